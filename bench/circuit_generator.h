@@ -0,0 +1,352 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef CIRCUIT_GENERATOR_H
+#define CIRCUIT_GENERATOR_H
+
+#include "cell_index.h"
+#include "wireworld_types.h"
+#include "quicky_exception.h"
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // Synthetic circuits of approximately a given number of cells that stay
+  // active forever. Random values come from std::mt19937 raw output so that
+  // a seed gives the same circuit with any standard library
+  class circuit_generator
+  {
+  public:
+    typedef enum class circuit {WIRE_GRID, CLOCK_LOOPS, DIODES, RANDOM} t_circuit;
+
+    inline circuit_generator(const t_circuit & p_circuit,
+                             const uint64_t & p_nb_cells,
+                             const uint32_t & p_seed);
+
+    // Build index of active cells with their state. Cells without neighbour
+    // are inactive
+    inline cell_index * build(std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                              wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
+                              uint32_t & p_x_max,
+                              uint32_t & p_y_max)const;
+
+    inline static std::string circuit2string(const t_circuit & p_circuit);
+    inline static t_circuit string2circuit(const std::string & p_name);
+  private:
+    // Side of square board giving p_nb_cells cells with given density
+    inline static uint32_t get_side(const uint64_t & p_nb_cells,
+                                    const double & p_density);
+    inline void set(const uint32_t & p_x,
+                    const uint32_t & p_y,
+                    const char & p_cell);
+    inline char get(const int64_t & p_x,
+                    const int64_t & p_y)const;
+
+    // Period 10 clock whose top left corner is at given position
+    inline void add_clock(const uint32_t & p_x,
+                          const uint32_t & p_y);
+
+    inline void generate_wire_grid(void);
+    inline void generate_clock_loops(void);
+    inline void generate_diodes(void);
+    inline void generate_random(void);
+
+    uint32_t m_width;
+    uint32_t m_height;
+    // ' ' for empty, '#' for copper, 'E' for electron, 'T' for tail
+    std::vector<char> m_cells;
+    std::mt19937 m_random;
+  };
+
+  //----------------------------------------------------------------------------
+  circuit_generator::circuit_generator(const t_circuit & p_circuit,
+                                       const uint64_t & p_nb_cells,
+                                       const uint32_t & p_seed):
+    m_width(0),
+    m_height(0),
+    m_random(p_seed)
+    {
+      switch(p_circuit)
+        {
+        case t_circuit::WIRE_GRID:
+          m_width = m_height = get_side(p_nb_cells,0.36);
+          m_cells.resize(((uint64_t)m_width) * m_height,' ');
+          generate_wire_grid();
+          break;
+        case t_circuit::CLOCK_LOOPS:
+          m_width = m_height = get_side(p_nb_cells,10.0 / 28);
+          m_cells.resize(((uint64_t)m_width) * m_height,' ');
+          generate_clock_loops();
+          break;
+        case t_circuit::DIODES:
+          m_width = m_height = get_side(p_nb_cells,0.36);
+          m_cells.resize(((uint64_t)m_width) * m_height,' ');
+          generate_diodes();
+          break;
+        case t_circuit::RANDOM:
+          m_width = m_height = get_side(p_nb_cells,0.45);
+          m_cells.resize(((uint64_t)m_width) * m_height,' ');
+          generate_random();
+          break;
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  cell_index * circuit_generator::build(std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                        wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
+                                        uint32_t & p_x_max,
+                                        uint32_t & p_y_max)const
+  {
+    p_states.clear();
+    p_x_max = 0;
+    p_y_max = 0;
+    // Board is scanned in row major order so ids are given in index order
+    std::vector<cell_index::t_cell_id> l_ids(m_cells.size(),UINT32_MAX);
+    std::vector<wireworld_common::wireworld_types::t_coordinates> l_coordinates;
+    for(uint32_t l_y = 0 ; l_y < m_height ; ++l_y)
+      {
+        for(uint32_t l_x = 0 ; l_x < m_width ; ++l_x)
+          {
+            char l_cell = get(l_x,l_y);
+            if(' ' == l_cell)
+              {
+                continue;
+              }
+            p_x_max = std::max(p_x_max,l_x);
+            p_y_max = std::max(p_y_max,l_y);
+            bool l_connected = false;
+            for(int l_dy = -1 ; !l_connected && l_dy <= 1 ; ++l_dy)
+              {
+                for(int l_dx = -1 ; !l_connected && l_dx <= 1 ; ++l_dx)
+                  {
+                    l_connected = (l_dx || l_dy) && ' ' != get(((int64_t)l_x) + l_dx,((int64_t)l_y) + l_dy);
+                  }
+              }
+            if(!l_connected)
+              {
+                p_inactive_cells.push_back(wireworld_common::wireworld_types::t_coordinates(l_x,l_y));
+                continue;
+              }
+            l_ids[((uint64_t)l_y) * m_width + l_x] = l_coordinates.size();
+            l_coordinates.push_back(wireworld_common::wireworld_types::t_coordinates(l_x,l_y));
+            p_states.push_back('E' == l_cell ? wireworld_common::wireworld_types::t_cell_state::ELECTRON : ('T' == l_cell ? wireworld_common::wireworld_types::t_cell_state::TAIL : wireworld_common::wireworld_types::t_cell_state::COPPER));
+          }
+      }
+    std::vector<uint32_t> l_offsets;
+    std::vector<cell_index::t_cell_id> l_neighbours;
+    l_offsets.reserve(l_coordinates.size() + 1);
+    for(auto l_iter: l_coordinates)
+      {
+        l_offsets.push_back(l_neighbours.size());
+        for(int l_dy = -1 ; l_dy <= 1 ; ++l_dy)
+          {
+            for(int l_dx = -1 ; l_dx <= 1 ; ++l_dx)
+              {
+                int64_t l_x = ((int64_t)l_iter.first) + l_dx;
+                int64_t l_y = ((int64_t)l_iter.second) + l_dy;
+                if((l_dx || l_dy) && ' ' != get(l_x,l_y))
+                  {
+                    l_neighbours.push_back(l_ids[l_y * m_width + l_x]);
+                  }
+              }
+          }
+      }
+    l_offsets.push_back(l_neighbours.size());
+    return new cell_index(std::move(l_coordinates),std::move(l_offsets),std::move(l_neighbours));
+  }
+
+  //----------------------------------------------------------------------------
+  std::string circuit_generator::circuit2string(const t_circuit & p_circuit)
+  {
+    switch(p_circuit)
+      {
+      case t_circuit::WIRE_GRID:
+        return "wire_grid";
+        break;
+      case t_circuit::CLOCK_LOOPS:
+        return "clock_loops";
+        break;
+      case t_circuit::DIODES:
+        return "diodes";
+        break;
+      case t_circuit::RANDOM:
+        return "random";
+        break;
+      }
+    return "";
+  }
+
+  //----------------------------------------------------------------------------
+  circuit_generator::t_circuit circuit_generator::string2circuit(const std::string & p_name)
+  {
+    if("wire_grid" == p_name)
+      {
+        return t_circuit::WIRE_GRID;
+      }
+    if("clock_loops" == p_name)
+      {
+        return t_circuit::CLOCK_LOOPS;
+      }
+    if("diodes" == p_name)
+      {
+        return t_circuit::DIODES;
+      }
+    if("random" == p_name)
+      {
+        return t_circuit::RANDOM;
+      }
+    throw quicky_exception::quicky_runtime_exception("Unknown circuit \"" + p_name + "\"",__LINE__,__FILE__);
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t circuit_generator::get_side(const uint64_t & p_nb_cells,
+                                       const double & p_density)
+  {
+    uint32_t l_side = (uint32_t)std::ceil(std::sqrt(p_nb_cells / p_density));
+    return l_side < 16 ? 16 : l_side;
+  }
+
+  //----------------------------------------------------------------------------
+  void circuit_generator::set(const uint32_t & p_x,
+                              const uint32_t & p_y,
+                              const char & p_cell)
+  {
+    if(p_x < m_width && p_y < m_height)
+      {
+        m_cells[((uint64_t)p_y) * m_width + p_x] = p_cell;
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  char circuit_generator::get(const int64_t & p_x,
+                              const int64_t & p_y)const
+  {
+    if(p_x < 0 || p_y < 0 || p_x >= m_width || p_y >= m_height)
+      {
+        return ' ';
+      }
+    return m_cells[p_y * m_width + p_x];
+  }
+
+  //----------------------------------------------------------------------------
+  void circuit_generator::add_clock(const uint32_t & p_x,
+                                    const uint32_t & p_y)
+  {
+    const char * l_pattern[3] = {" TE## ","#    #"," #### "};
+    for(uint32_t l_y = 0 ; l_y < 3 ; ++l_y)
+      {
+        for(uint32_t l_x = 0 ; l_x < 6 ; ++l_x)
+          {
+            if(' ' != l_pattern[l_y][l_x])
+              {
+                set(p_x + l_x,p_y + l_y,l_pattern[l_y][l_x]);
+              }
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void circuit_generator::generate_wire_grid(void)
+  {
+    // Mesh of wires every 5 cells fed by pulses located on random segments
+    for(uint32_t l_y = 0 ; l_y < m_height ; ++l_y)
+      {
+        for(uint32_t l_x = 0 ; l_x < m_width ; ++l_x)
+          {
+            if(!(l_x % 5) || !(l_y % 5))
+              {
+                set(l_x,l_y,'#');
+              }
+          }
+      }
+    uint64_t l_nb_pulses = m_cells.size() / 150 + 1;
+    for(uint64_t l_index = 0 ; l_index < l_nb_pulses ; ++l_index)
+      {
+        uint32_t l_y = (m_random() % ((m_height + 4) / 5)) * 5;
+        uint32_t l_x = (m_random() % ((m_width + 4) / 5)) * 5 + 1;
+        if(l_x + 1 < m_width && l_y < m_height)
+          {
+            set(l_x,l_y,'T');
+            set(l_x + 1,l_y,'E');
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void circuit_generator::generate_clock_loops(void)
+  {
+    // Isolated clocks in 7x4 tiles
+    for(uint32_t l_y = 0 ; l_y + 3 <= m_height ; l_y += 4)
+      {
+        for(uint32_t l_x = 0 ; l_x + 6 <= m_width ; l_x += 7)
+          {
+            add_clock(l_x,l_y);
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void circuit_generator::generate_diodes(void)
+  {
+    // Rows made of a clock feeding a wire interrupted by a diode every 7
+    // cells
+    for(uint32_t l_y = 0 ; l_y + 3 <= m_height ; l_y += 4)
+      {
+        add_clock(0,l_y);
+        for(uint32_t l_x = 6 ; l_x < m_width ; ++l_x)
+          {
+            set(l_x,l_y + 1,'#');
+          }
+        for(uint32_t l_x = 12 ; l_x + 2 < m_width ; l_x += 7)
+          {
+            set(l_x,l_y + 1,' ');
+            set(l_x - 1,l_y,'#');
+            set(l_x,l_y,'#');
+            set(l_x - 1,l_y + 2,'#');
+            set(l_x,l_y + 2,'#');
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void circuit_generator::generate_random(void)
+  {
+    // 45% of copper including 3% of electrons
+    for(uint32_t l_y = 0 ; l_y < m_height ; ++l_y)
+      {
+        for(uint32_t l_x = 0 ; l_x < m_width ; ++l_x)
+          {
+            uint32_t l_value = m_random() % 1000;
+            if(l_value < 30)
+              {
+                set(l_x,l_y,'E');
+              }
+            else if(l_value < 450)
+              {
+                set(l_x,l_y,'#');
+              }
+          }
+      }
+  }
+}
+#endif // CIRCUIT_GENERATOR_H
+//EOF
@@ -0,0 +1,321 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include "circuit_generator.h"
+#include "wireworld_configuration.h"
+#include "simulation_options.h"
+#include "engine_factory.h"
+#include "engine_runner.h"
+#include "top.h"
+#include "hardware_counters.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+// Each case runs in its own process: SystemC allows a single elaboration per
+// process and memory of a case does not impact following ones. Result of a
+// case is a CSV line written in a pipe, standard output of case process is
+// discarded
+
+typedef std::chrono::steady_clock t_clock;
+
+//------------------------------------------------------------------------------
+double get_duration(const t_clock::time_point & p_start,
+                    const t_clock::time_point & p_end)
+{
+  return std::chrono::duration<double>(p_end - p_start).count();
+}
+
+//------------------------------------------------------------------------------
+std::vector<std::string> split(const std::string & p_list)
+{
+  std::vector<std::string> l_result;
+  std::stringstream l_stream(p_list);
+  std::string l_item;
+  while(std::getline(l_stream,l_item,','))
+    {
+      l_result.push_back(l_item);
+    }
+  return l_result;
+}
+
+//------------------------------------------------------------------------------
+bool get_value(const std::string & p_arg,
+               const std::string & p_name,
+               std::string & p_value)
+{
+  std::string l_prefix = "--" + p_name + "=";
+  if(p_arg.compare(0,l_prefix.size(),l_prefix))
+    {
+      return false;
+    }
+  p_value = p_arg.substr(l_prefix.size());
+  return true;
+}
+
+//------------------------------------------------------------------------------
+std::string run_case(const wireworld_systemc::circuit_generator::t_circuit & p_circuit,
+                     const uint64_t & p_nb_cells,
+                     const std::string & p_engine,
+                     const uint32_t & p_seed,
+                     const uint32_t & p_warmup,
+                     const uint32_t & p_nb_generations,
+                     const std::vector<std::string> & p_engine_options)
+{
+  // Engine options are given to simulation options like on command line
+  std::vector<std::string> l_args;
+  l_args.push_back("wireworld_bench");
+  l_args.push_back("--engine=" + p_engine);
+  l_args.push_back("--headless");
+  l_args.insert(l_args.end(),p_engine_options.begin(),p_engine_options.end());
+  std::vector<char*> l_argv;
+  for(auto & l_iter: l_args)
+    {
+      l_argv.push_back(&l_iter[0]);
+    }
+  l_argv.push_back(nullptr);
+  int l_argc = l_args.size();
+  wireworld_systemc::simulation_options l_options;
+  l_options.extract(l_argc,&l_argv[0]);
+
+  std::vector<wireworld_common::wireworld_types::t_cell_state> l_states;
+  wireworld_common::wireworld_types::t_cell_list l_inactive_cells;
+  uint32_t l_x_max = 0;
+  uint32_t l_y_max = 0;
+  wireworld_systemc::cell_index * l_index = wireworld_systemc::circuit_generator(p_circuit,p_nb_cells,p_seed).build(l_states,l_inactive_cells,l_x_max,l_y_max);
+  // Generated circuits are in row major order
+  if(wireworld_systemc::cell_index::t_order::ROW_MAJOR != l_options.get_cell_order())
+    {
+      wireworld_systemc::cell_index * l_reordered = new wireworld_systemc::cell_index(*l_index,l_options.get_cell_order());
+      std::vector<wireworld_common::wireworld_types::t_cell_state> l_reordered_states(l_states.size());
+      for(wireworld_systemc::cell_index::t_cell_id l_id = 0 ; l_id < l_index->get_nb_cells() ; ++l_id)
+        {
+          l_reordered_states[l_reordered->get_id(l_index->get_coordinates(l_id))] = l_states[l_id];
+        }
+      delete l_index;
+      l_index = l_reordered;
+      l_states.swap(l_reordered_states);
+    }
+
+  wireworld_common::wireworld_configuration l_config;
+  l_config.set_nb_max_cycle(p_warmup + p_nb_generations + 1);
+
+  double l_elaboration = 0;
+  double l_stepping = 0;
+  // Only measured generations are counted
+  wireworld_systemc::hardware_counters l_hardware;
+  uint64_t l_nb_generations = 0;
+  if(l_options.is_systemc_engine())
+    {
+      t_clock::time_point l_start = t_clock::now();
+      wireworld_systemc::top * l_top = new wireworld_systemc::top("top",*l_index,l_states,0,l_config,l_x_max,l_y_max,l_inactive_cells,l_options);
+      l_elaboration = get_duration(l_start,t_clock::now());
+      sc_start(l_top->get_clock_period() * p_warmup);
+      uint64_t l_first_generation = l_top->get_generation();
+      l_start = t_clock::now();
+      l_hardware.enable();
+      sc_start(l_top->get_clock_period() * p_nb_generations);
+      l_hardware.disable();
+      l_stepping = get_duration(l_start,t_clock::now());
+      l_nb_generations = l_top->get_generation() - l_first_generation;
+      // Case process ends without destroying simulation
+    }
+  else
+    {
+      t_clock::time_point l_start = t_clock::now();
+      wireworld_systemc::engine_if * l_engine = wireworld_systemc::engine_factory::create(l_options.get_engine(),*l_index,l_states,l_options);
+      l_elaboration = get_duration(l_start,t_clock::now());
+      l_config.set_nb_max_cycle(p_warmup);
+      {
+        wireworld_systemc::engine_runner l_runner(*l_engine,*l_index,0,l_config,l_x_max,l_y_max,l_inactive_cells,l_options);
+        l_runner.run();
+      }
+      l_config.set_nb_max_cycle(p_warmup + p_nb_generations);
+      wireworld_systemc::engine_runner l_runner(*l_engine,*l_index,p_warmup,l_config,l_x_max,l_y_max,l_inactive_cells,l_options);
+      l_start = t_clock::now();
+      l_hardware.enable();
+      l_runner.run();
+      l_hardware.disable();
+      l_stepping = get_duration(l_start,t_clock::now());
+      l_nb_generations = l_runner.get_generation() - 1 - p_warmup;
+    }
+
+  std::stringstream l_stream;
+  l_stream << wireworld_systemc::circuit_generator::circuit2string(p_circuit) << "," << p_nb_cells << "," << l_index->get_nb_cells() << "," << p_engine << "," << wireworld_systemc::cell_index::order2string(l_options.get_cell_order()) << "," << l_elaboration << "," << l_nb_generations << "," << l_stepping << "," << (l_stepping > 0 ? l_nb_generations / l_stepping : 0) << "," << (l_stepping > 0 ? l_nb_generations * l_index->get_nb_cells() / l_stepping : 0);
+  for(unsigned int l_event = 0 ; l_event < wireworld_systemc::hardware_counters::m_nb_events ; ++l_event)
+    {
+      uint64_t l_value = 0;
+      l_stream << "," ;
+      if(l_hardware.get((wireworld_systemc::hardware_counters::t_event)l_event,l_value))
+        {
+          l_stream << l_value;
+        }
+    }
+  return l_stream.str();
+}
+
+//------------------------------------------------------------------------------
+std::string fork_case(const wireworld_systemc::circuit_generator::t_circuit & p_circuit,
+                      const uint64_t & p_nb_cells,
+                      const std::string & p_engine,
+                      const uint32_t & p_seed,
+                      const uint32_t & p_warmup,
+                      const uint32_t & p_nb_generations,
+                      const std::vector<std::string> & p_engine_options)
+{
+  int l_pipe[2];
+  if(pipe(l_pipe))
+    {
+      throw quicky_exception::quicky_runtime_exception("Unable to create pipe",__LINE__,__FILE__);
+    }
+  std::cout.flush();
+  pid_t l_pid = fork();
+  if(l_pid < 0)
+    {
+      throw quicky_exception::quicky_runtime_exception("Unable to create process",__LINE__,__FILE__);
+    }
+  if(!l_pid)
+    {
+      close(l_pipe[0]);
+      int l_null = open("/dev/null",O_WRONLY);
+      dup2(l_null,STDOUT_FILENO);
+      std::string l_result;
+      try
+        {
+          l_result = run_case(p_circuit,p_nb_cells,p_engine,p_seed,p_warmup,p_nb_generations,p_engine_options);
+        }
+      catch(quicky_exception::quicky_logic_exception & e)
+        {
+          l_result = std::string("error: ") + e.what();
+        }
+      catch(quicky_exception::quicky_runtime_exception & e)
+        {
+          l_result = std::string("error: ") + e.what();
+        }
+      ssize_t l_written = write(l_pipe[1],l_result.c_str(),l_result.size());
+      _exit(l_written == (ssize_t)l_result.size() ? 0 : 1);
+    }
+  close(l_pipe[1]);
+  std::string l_result;
+  char l_buffer[256];
+  ssize_t l_size;
+  while((l_size = read(l_pipe[0],l_buffer,sizeof(l_buffer))) > 0)
+    {
+      l_result.append(l_buffer,l_size);
+    }
+  close(l_pipe[0]);
+  int l_status = 0;
+  waitpid(l_pid,&l_status,0);
+  if(l_result.empty() || !WIFEXITED(l_status) || WEXITSTATUS(l_status))
+    {
+      std::stringstream l_stream;
+      l_stream << wireworld_systemc::circuit_generator::circuit2string(p_circuit) << "," << p_nb_cells << ",,"  << p_engine << ",,,,,,,,,";
+      return l_stream.str() + (l_result.empty() ? "error: case process failed" : l_result);
+    }
+  return l_result;
+}
+
+//------------------------------------------------------------------------------
+int sc_main(int argc,char ** argv)
+{
+  try
+    {
+      std::vector<std::string> l_circuits = split("wire_grid,clock_loops,diodes,random");
+      std::vector<std::string> l_engines = split("cell,partition,bitplane,parallel,hashlife");
+      uint64_t l_min_cells = 1000;
+      uint64_t l_max_cells = 10000000;
+      uint32_t l_warmup = 20;
+      uint32_t l_nb_generations = 100;
+      uint32_t l_seed = 1;
+      // Other options are given to engines
+      std::vector<std::string> l_engine_options;
+      for(int l_index = 1 ; l_index < argc ; ++l_index)
+        {
+          std::string l_arg(argv[l_index]);
+          std::string l_value;
+          if(get_value(l_arg,"circuits",l_value))
+            {
+              l_circuits = split(l_value);
+            }
+          else if(get_value(l_arg,"engines",l_value))
+            {
+              l_engines = split(l_value);
+            }
+          else if(get_value(l_arg,"min_cells",l_value))
+            {
+              l_min_cells = std::strtoull(l_value.c_str(),nullptr,10);
+            }
+          else if(get_value(l_arg,"max_cells",l_value))
+            {
+              l_max_cells = std::strtoull(l_value.c_str(),nullptr,10);
+            }
+          else if(get_value(l_arg,"warmup",l_value))
+            {
+              l_warmup = std::strtoul(l_value.c_str(),nullptr,10);
+            }
+          else if(get_value(l_arg,"generations",l_value))
+            {
+              l_nb_generations = std::strtoul(l_value.c_str(),nullptr,10);
+            }
+          else if(get_value(l_arg,"seed",l_value))
+            {
+              l_seed = std::strtoul(l_value.c_str(),nullptr,10);
+            }
+          else
+            {
+              l_engine_options.push_back(l_arg);
+            }
+        }
+
+      std::cout << "circuit,target_cells,cells,engine,cell_order,elaboration_seconds,generations,stepping_seconds,generations_per_second,cell_updates_per_second,cache_references,cache_misses,l1d_read_misses" << std::endl ;
+      for(auto l_circuit_name: l_circuits)
+        {
+          wireworld_systemc::circuit_generator::t_circuit l_circuit = wireworld_systemc::circuit_generator::string2circuit(l_circuit_name);
+          // Sizes are powers of ten
+          for(uint64_t l_nb_cells = 1 ; l_nb_cells <= l_max_cells ; l_nb_cells *= 10)
+            {
+              if(l_nb_cells < l_min_cells)
+                {
+                  continue;
+                }
+              for(auto l_engine: l_engines)
+                {
+                  std::cout << fork_case(l_circuit,l_nb_cells,l_engine,l_seed,l_warmup,l_nb_generations,l_engine_options) << std::endl ;
+                }
+            }
+        }
+    }
+  catch(quicky_exception::quicky_logic_exception & e)
+    {
+      std::cout << "ERROR : Logic exception : " << e.what() << std::endl ;
+      return -1;
+    }
+  catch(quicky_exception::quicky_runtime_exception & e)
+    {
+      std::cout << "ERROR : Runtime exception : " << e.what() << std::endl ;
+      return -1;
+    }
+  return 0;
+}
+//EOF
@@ -0,0 +1,117 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace wireworld_systemc
+{
+  // Objects created during elaboration are placed one after the other in
+  // large chunks of memory. Destructors are called in reverse order of
+  // creation and chunks are freed at once when arena is destroyed
+  class arena
+  {
+  public:
+    inline arena(const size_t & p_chunk_size = 1 << 20);
+    inline ~arena(void);
+
+    template <class T, class... ARGS>
+      inline T * create(ARGS&&... p_args);
+  private:
+    arena(const arena &) = delete;
+    arena & operator=(const arena &) = delete;
+
+    inline void * allocate(const size_t & p_size, const size_t & p_alignment);
+
+    template <class T>
+      inline static void destroy(void * p_object);
+
+    typedef void (*t_destructor)(void *);
+
+    size_t m_chunk_size;
+    std::vector<char*> m_chunks;
+    char * m_current;
+    size_t m_remaining;
+    std::vector<std::pair<void*,t_destructor>> m_objects;
+  };
+
+  //----------------------------------------------------------------------------
+  arena::arena(const size_t & p_chunk_size):
+    m_chunk_size(p_chunk_size),
+    m_current(nullptr),
+    m_remaining(0)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  arena::~arena(void)
+    {
+      for(std::vector<std::pair<void*,t_destructor>>::reverse_iterator l_iter = m_objects.rbegin() ; m_objects.rend() != l_iter ; ++l_iter)
+        {
+          l_iter->second(l_iter->first);
+        }
+      for(auto l_iter: m_chunks)
+        {
+          delete[] l_iter;
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  template <class T, class... ARGS>
+    T * arena::create(ARGS&&... p_args)
+    {
+      void * l_memory = allocate(sizeof(T),alignof(T));
+      T * l_object = new(l_memory) T(std::forward<ARGS>(p_args)...);
+      m_objects.push_back(std::pair<void*,t_destructor>(l_object,&arena::destroy<T>));
+      return l_object;
+    }
+
+  //----------------------------------------------------------------------------
+  void * arena::allocate(const size_t & p_size, const size_t & p_alignment)
+  {
+    size_t l_padding = (p_alignment - ((uintptr_t)m_current) % p_alignment) % p_alignment;
+    if(!m_current || l_padding + p_size > m_remaining)
+      {
+        // Memory returned by new[] is suitably aligned for any object
+        size_t l_chunk_size = p_size > m_chunk_size ? p_size : m_chunk_size;
+        m_chunks.push_back(new char[l_chunk_size]);
+        m_current = m_chunks.back();
+        m_remaining = l_chunk_size;
+        l_padding = 0;
+      }
+    void * l_result = m_current + l_padding;
+    m_current += l_padding + p_size;
+    m_remaining -= l_padding + p_size;
+    return l_result;
+  }
+
+  //----------------------------------------------------------------------------
+  template <class T>
+    void arena::destroy(void * p_object)
+    {
+      static_cast<T*>(p_object)->~T();
+    }
+}
+#endif // ARENA_H
+//EOF
@@ -0,0 +1,222 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef ASYNC_RENDERER_H
+#define ASYNC_RENDERER_H
+
+#include "spsc_queue.h"
+#include "gui_display.h"
+#include "display_if.h"
+#include "wireworld_types.h"
+#include "wireworld_gui.h"
+#include "SDL.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+namespace wireworld_systemc
+{
+  // Display thread fed with cell state changes. Simulation gives changes as
+  // they happen, they are gathered in a frame handed to display thread on
+  // refresh so that display cost depends on activity and not on board size.
+  // A frame holds at most one change per cell, the last one. Simulation
+  // never waits: when display is late the frame that could not be handed
+  // over is dropped as such and kept as pending changes that next changes
+  // overwrite, so pending data stays bounded by board size. Once renderer
+  // is created, GUI must only be used by display thread. Frame buffers go
+  // back to simulation through a second queue to be reused. Only screen
+  // areas containing redrawn cells are updated
+  class async_renderer: public display_if
+  {
+  public:
+    inline async_renderer(wireworld_common::wireworld_gui & p_gui,
+                          const uint32_t & p_width,
+                          const uint32_t & p_height,
+                          const unsigned int & p_display_duration);
+    inline ~async_renderer(void);
+
+    // Method inherited from display_if
+    inline void display_cell(const uint32_t & p_x,
+                             const uint32_t & p_y,
+                             const wireworld_common::wireworld_types::t_cell_state & p_state);
+    // End of method inherited from display_if
+
+    // Give changes gathered since last successful push to display thread
+    inline void push_frame(void);
+  private:
+    typedef struct
+    {
+      uint32_t m_x;
+      uint32_t m_y;
+      wireworld_common::wireworld_types::t_cell_state m_state;
+    } t_change;
+    typedef std::vector<t_change> t_frame;
+
+    inline void render(void);
+    inline void draw(t_frame & p_frame);
+
+    // Only used by display thread once renderer is created
+    gui_display m_gui_display;
+    unsigned int m_display_duration;
+
+    spsc_queue<t_frame*> m_frames;
+    spsc_queue<t_frame*> m_free_frames;
+    t_frame * m_pending;
+    // Position in m_pending plus one of change of each cell, 0 when cell
+    // has no pending change
+    std::vector<uint32_t> m_pending_index;
+    uint64_t m_nb_late;
+
+    uint32_t m_width;
+
+    std::atomic<bool> m_terminate;
+    std::thread m_thread;
+  };
+
+  //----------------------------------------------------------------------------
+  async_renderer::async_renderer(wireworld_common::wireworld_gui & p_gui,
+                                 const uint32_t & p_width,
+                                 const uint32_t & p_height,
+                                 const unsigned int & p_display_duration):
+    m_gui_display(p_gui,p_width,p_height),
+    m_display_duration(p_display_duration),
+    m_frames(4),
+    m_free_frames(4),
+    m_pending(new t_frame()),
+    m_pending_index((size_t)p_width * p_height,0),
+    m_nb_late(0),
+    m_width(p_width),
+    m_terminate(false),
+    m_thread(&async_renderer::render,this)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  async_renderer::~async_renderer(void)
+    {
+      m_terminate.store(true,std::memory_order_release);
+      m_thread.join();
+      // Display thread is over, last changes are drawn here
+      if(!m_pending->empty())
+        {
+          draw(*m_pending);
+        }
+      t_frame * l_frame = nullptr;
+      while(m_frames.pop(l_frame))
+        {
+          delete l_frame;
+        }
+      while(m_free_frames.pop(l_frame))
+        {
+          delete l_frame;
+        }
+      delete m_pending;
+      if(m_nb_late)
+        {
+          std::cout << "Number of frames dropped as display was late : " << m_nb_late << std::endl;
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  void async_renderer::display_cell(const uint32_t & p_x,
+                                    const uint32_t & p_y,
+                                    const wireworld_common::wireworld_types::t_cell_state & p_state)
+  {
+    uint32_t & l_index = m_pending_index[(size_t)p_y * m_width + p_x];
+    if(l_index)
+      {
+        (*m_pending)[l_index - 1].m_state = p_state;
+        return;
+      }
+    t_change l_change = {p_x,p_y,p_state};
+    m_pending->push_back(l_change);
+    l_index = m_pending->size();
+  }
+
+  //----------------------------------------------------------------------------
+  void async_renderer::push_frame(void)
+  {
+    if(m_pending->empty())
+      {
+        return;
+      }
+    // Frame is no more updated by simulation once pushed
+    for(auto & l_change: *m_pending)
+      {
+        m_pending_index[(size_t)l_change.m_y * m_width + l_change.m_x] = 0;
+      }
+    if(!m_frames.push(m_pending))
+      {
+        // Changes stay pending, next ones replace them
+        for(uint32_t l_index = 0 ; l_index < m_pending->size() ; ++l_index)
+          {
+            m_pending_index[(size_t)(*m_pending)[l_index].m_y * m_width + (*m_pending)[l_index].m_x] = l_index + 1;
+          }
+        ++m_nb_late;
+        return;
+      }
+    if(!m_free_frames.pop(m_pending))
+      {
+        m_pending = new t_frame();
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void async_renderer::render(void)
+  {
+    while(true)
+      {
+        // Read flag before queue so that frames pushed before termination
+        // are displayed
+        bool l_terminate = m_terminate.load(std::memory_order_acquire);
+        t_frame * l_frame = nullptr;
+        if(m_frames.pop(l_frame))
+          {
+            draw(*l_frame);
+            if(!m_free_frames.push(l_frame))
+              {
+                delete l_frame;
+              }
+          }
+        else if(l_terminate)
+          {
+            return;
+          }
+        else
+          {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void async_renderer::draw(t_frame & p_frame)
+  {
+    for(auto & l_change: p_frame)
+      {
+        m_gui_display.display_cell(l_change.m_x,l_change.m_y,l_change.m_state);
+      }
+    p_frame.clear();
+    m_gui_display.update_screen();
+    SDL_Delay(m_display_duration);
+  }
+}
+#endif // ASYNC_RENDERER_H
+//EOF
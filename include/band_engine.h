@@ -0,0 +1,419 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef BAND_ENGINE_H
+#define BAND_ENGINE_H
+
+#include "engine_if.h"
+#include "bitplane_engine.h"
+#include "cell_index.h"
+#include "quicky_exception.h"
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace wireworld_systemc
+{
+  // Out of core version of bitplane engine. Copper, electron and tail planes
+  // are stored in an unlinked file mapped in memory and cut in bands of rows.
+  // A generation is computed band after band with a window of three bands:
+  // next states of previous band wait in memory until current band, which
+  // reads last row of previous band, is computed, and first row of next band
+  // is read. Bands around which nothing is active are neither read nor
+  // written and pages of a band are released once it has been written back,
+  // so resident memory depends on band size and not on board height
+  class band_engine: public engine_if
+  {
+  public:
+    // File is created in directory p_directory
+    inline band_engine(const cell_index & p_index,
+                       const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                       const uint32_t & p_band_height,
+                       const std::string & p_directory);
+    // States are one byte per cell as stored in checkpoint file, so that
+    // they can be read in place from a mapped netlist
+    inline band_engine(const cell_index & p_index,
+                       const uint8_t * p_states,
+                       const uint32_t & p_band_height,
+                       const std::string & p_directory);
+    inline ~band_engine(void);
+    band_engine(const band_engine &) = delete;
+    band_engine & operator=(const band_engine &) = delete;
+
+    // Methods inherited from engine_if
+    inline void step(void);
+    inline uint32_t get_nb_electron(void)const;
+    inline uint32_t get_nb_tail(void)const;
+    inline wireworld_common::wireworld_types::t_cell_state get_state(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const;
+    inline void display_changes(display_if & p_display);
+    // End of methods inherited from engine_if
+  private:
+    typedef bitplane_engine::t_word t_word;
+    typedef enum class plane {COPPER=0, ELECTRON, TAIL} t_plane;
+
+    // Create band file, planes are empty
+    inline band_engine(const cell_index & p_index,
+                       const uint32_t & p_band_height,
+                       const std::string & p_directory);
+    template <class STATES>
+      inline void set_cells(const cell_index & p_index,
+                            const STATES & p_states);
+
+    inline t_word * get_row(const t_plane & p_plane,
+                            const uint32_t & p_row)const;
+    inline bool is_set(const t_plane & p_plane,
+                       const uint32_t & p_x,
+                       const uint32_t & p_y)const;
+    inline void set(const t_plane & p_plane,
+                    const wireworld_common::wireworld_types::t_coordinates & p_coordinates);
+    // Compute next electrons and tails of band in p_window, return number of
+    // electrons and tell if band is active
+    inline uint32_t compute_band(const uint32_t & p_band,
+                                 std::vector<t_word> & p_window,
+                                 bool & p_active)const;
+    inline void write_band(const uint32_t & p_band,
+                           const std::vector<t_word> & p_window);
+    // Give back to system pages of bands [p_first_band,p_last_band[
+    inline void release(const uint32_t & p_first_band,
+                        const uint32_t & p_last_band)const;
+
+    // Position (x,y) is bit x + 1 of row y + 1 like in bitplane engine. A row
+    // is stored as copper, electron and tail words, each plane row being
+    // surrounded by one zero word on each side. Bands are aligned on pages
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_nb_words;
+    uint32_t m_stride;
+    uint32_t m_band_height;
+    uint32_t m_nb_bands;
+    size_t m_band_size;
+
+    int m_fd;
+    t_word * m_data;
+    size_t m_size;
+
+    // Bands containing an electron or a tail
+    std::vector<uint8_t> m_active_bands;
+    std::vector<uint8_t> m_next_active_bands;
+    // Bands having changed since last display
+    std::vector<uint8_t> m_changed_bands;
+    // Next electron then tail rows of previous and current band
+    std::vector<t_word> m_windows[2];
+
+    uint32_t m_nb_electron;
+    uint32_t m_nb_tail;
+
+    // Cells set at creation between two releases of whole mapping
+    static const cell_index::t_cell_id m_release_interval = 1 << 20;
+  };
+
+  //----------------------------------------------------------------------------
+  band_engine::band_engine(const cell_index & p_index,
+                           const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                           const uint32_t & p_band_height,
+                           const std::string & p_directory):
+    band_engine(p_index,p_band_height,p_directory)
+    {
+      set_cells(p_index,p_states);
+    }
+
+  //----------------------------------------------------------------------------
+  band_engine::band_engine(const cell_index & p_index,
+                           const uint8_t * p_states,
+                           const uint32_t & p_band_height,
+                           const std::string & p_directory):
+    band_engine(p_index,p_band_height,p_directory)
+    {
+      set_cells(p_index,p_states);
+    }
+
+  //----------------------------------------------------------------------------
+  band_engine::band_engine(const cell_index & p_index,
+                           const uint32_t & p_band_height,
+                           const std::string & p_directory):
+    m_width(0),
+    m_height(0),
+    m_nb_words(0),
+    m_stride(0),
+    m_band_height(p_band_height),
+    m_nb_bands(0),
+    m_band_size(0),
+    m_fd(-1),
+    m_data(nullptr),
+    m_size(0),
+    m_nb_electron(0),
+    m_nb_tail(0)
+    {
+      bitplane_engine::check_topology(p_index,"band");
+
+      uint32_t l_x_max = 0;
+      uint32_t l_y_max = 0;
+      for(cell_index::t_cell_id l_id = 0 ; l_id < p_index.get_nb_cells() ; ++l_id)
+        {
+          if(p_index.get_coordinates(l_id).first > l_x_max) l_x_max = p_index.get_coordinates(l_id).first;
+          if(p_index.get_coordinates(l_id).second > l_y_max) l_y_max = p_index.get_coordinates(l_id).second;
+          if(!((l_id + 1) % cell_index::m_release_interval)) p_index.release_pages();
+        }
+      p_index.release_pages();
+      m_width = l_x_max + 3;
+      m_height = l_y_max + 3;
+      m_nb_words = (m_width + 63) / 64;
+      m_stride = m_nb_words + 2;
+      m_nb_bands = (m_height + m_band_height - 1) / m_band_height;
+      size_t l_page_size = sysconf(_SC_PAGESIZE);
+      m_band_size = ((3 * sizeof(t_word) * m_stride * m_band_height + l_page_size - 1) / l_page_size) * l_page_size;
+      m_size = m_band_size * m_nb_bands;
+
+      // File is removed as soon as created so that it disappears with
+      // process. Its size is reserved lazily by file system
+      std::string l_name = p_directory + "/wireworld_bands_XXXXXX";
+      m_fd = mkstemp(&l_name[0]);
+      if(m_fd < 0)
+        {
+          throw quicky_exception::quicky_runtime_exception("Unable to create band file in \"" + p_directory + "\": " + strerror(errno),__LINE__,__FILE__);
+        }
+      unlink(l_name.c_str());
+      void * l_data = MAP_FAILED;
+      if(!ftruncate(m_fd,m_size))
+        {
+          l_data = mmap(nullptr,m_size,PROT_READ | PROT_WRITE,MAP_SHARED,m_fd,0);
+        }
+      if(MAP_FAILED == l_data)
+        {
+          std::string l_error(strerror(errno));
+          close(m_fd);
+          throw quicky_exception::quicky_runtime_exception("Unable to map band file in \"" + p_directory + "\": " + l_error,__LINE__,__FILE__);
+        }
+      m_data = (t_word*)l_data;
+
+      m_active_bands.resize(m_nb_bands,0);
+      m_next_active_bands.resize(m_nb_bands,0);
+      m_changed_bands.resize(m_nb_bands,1);
+      m_windows[0].resize(2 * ((size_t)m_stride) * m_band_height,0);
+      m_windows[1].resize(2 * ((size_t)m_stride) * m_band_height,0);
+    }
+
+  //----------------------------------------------------------------------------
+  template <class STATES>
+    void band_engine::set_cells(const cell_index & p_index,
+                                const STATES & p_states)
+    {
+      for(cell_index::t_cell_id l_id = 0 ; l_id < p_index.get_nb_cells() ; ++l_id)
+        {
+          const wireworld_common::wireworld_types::t_coordinates & l_coordinates = p_index.get_coordinates(l_id);
+          set(t_plane::COPPER,l_coordinates);
+          switch((wireworld_common::wireworld_types::t_cell_state)p_states[l_id])
+            {
+            case wireworld_common::wireworld_types::t_cell_state::ELECTRON:
+              set(t_plane::ELECTRON,l_coordinates);
+              ++m_nb_electron;
+              m_active_bands[(l_coordinates.second + 1) / m_band_height] = 1;
+              break;
+            case wireworld_common::wireworld_types::t_cell_state::TAIL:
+              set(t_plane::TAIL,l_coordinates);
+              ++m_nb_tail;
+              m_active_bands[(l_coordinates.second + 1) / m_band_height] = 1;
+              break;
+            default:
+              break;
+            }
+          // Cells are not necessarily sorted by row
+          if(!((l_id + 1) % m_release_interval))
+            {
+              release(0,m_nb_bands);
+              p_index.release_pages();
+            }
+        }
+      release(0,m_nb_bands);
+      p_index.release_pages();
+    }
+
+  //----------------------------------------------------------------------------
+  band_engine::~band_engine(void)
+    {
+      munmap(m_data,m_size);
+      close(m_fd);
+    }
+
+  //----------------------------------------------------------------------------
+  void band_engine::step(void)
+  {
+    uint32_t l_nb_electron = 0;
+    // Window holding next states of previous band, if it has been computed
+    unsigned int l_previous = 0;
+    bool l_previous_computed = false;
+    for(uint32_t l_band = 0 ; l_band < m_nb_bands ; ++l_band)
+      {
+        bool l_computed = m_active_bands[l_band] || (l_band && m_active_bands[l_band - 1]) || (l_band + 1 < m_nb_bands && m_active_bands[l_band + 1]);
+        bool l_active = false;
+        if(l_computed)
+          {
+            l_nb_electron += compute_band(l_band,m_windows[1 - l_previous],l_active);
+          }
+        m_next_active_bands[l_band] = l_active;
+        m_changed_bands[l_band] |= m_active_bands[l_band] || l_active;
+        // Previous band has been read for the last time
+        if(l_previous_computed)
+          {
+            write_band(l_band - 1,m_windows[l_previous]);
+            release(l_band - 1,l_band);
+            // First row of this band has been read but nothing is written
+            if(!l_computed)
+              {
+                release(l_band,l_band + 1);
+              }
+          }
+        l_previous = 1 - l_previous;
+        l_previous_computed = l_computed;
+      }
+    if(l_previous_computed)
+      {
+        write_band(m_nb_bands - 1,m_windows[l_previous]);
+        release(m_nb_bands - 1,m_nb_bands);
+      }
+    m_active_bands.swap(m_next_active_bands);
+    m_nb_tail = m_nb_electron;
+    m_nb_electron = l_nb_electron;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t band_engine::compute_band(const uint32_t & p_band,
+                                     std::vector<t_word> & p_window,
+                                     bool & p_active)const
+  {
+    uint32_t l_nb_electron = 0;
+    p_active = false;
+    std::fill(p_window.begin(),p_window.end(),0);
+    // First and last rows of board are margins
+    uint32_t l_first_row = std::max(p_band * m_band_height,(uint32_t)1);
+    uint32_t l_last_row = std::min((p_band + 1) * m_band_height,m_height - 1);
+    for(uint32_t l_row = l_first_row ; l_row < l_last_row ; ++l_row)
+      {
+        bitplane_engine::t_row l_row_words;
+        l_row_words.m_up = get_row(t_plane::ELECTRON,l_row - 1);
+        l_row_words.m_middle = get_row(t_plane::ELECTRON,l_row);
+        l_row_words.m_down = get_row(t_plane::ELECTRON,l_row + 1);
+        l_row_words.m_copper = get_row(t_plane::COPPER,l_row);
+        l_row_words.m_tail = get_row(t_plane::TAIL,l_row);
+        l_row_words.m_next_electron = &p_window[2 * ((size_t)m_stride) * (l_row - p_band * m_band_height)];
+        l_row_words.m_next_tail = l_row_words.m_next_electron + m_stride;
+        if(bitplane_engine::step_row(l_row_words,m_nb_words))
+          {
+            p_active = true;
+            l_nb_electron += bitplane_engine::count(l_row_words.m_next_electron + 1,m_nb_words);
+          }
+      }
+    return l_nb_electron;
+  }
+
+  //----------------------------------------------------------------------------
+  void band_engine::write_band(const uint32_t & p_band,
+                               const std::vector<t_word> & p_window)
+  {
+    uint32_t l_last_row = std::min((p_band + 1) * m_band_height,m_height);
+    for(uint32_t l_row = p_band * m_band_height ; l_row < l_last_row ; ++l_row)
+      {
+        const t_word * l_next = &p_window[2 * ((size_t)m_stride) * (l_row - p_band * m_band_height)];
+        memcpy(get_row(t_plane::ELECTRON,l_row),l_next,2 * sizeof(t_word) * m_stride);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void band_engine::release(const uint32_t & p_first_band,
+                            const uint32_t & p_last_band)const
+  {
+    // Data of a shared file mapping stays in file
+    madvise((char*)m_data + p_first_band * m_band_size,(p_last_band - p_first_band) * m_band_size,MADV_DONTNEED);
+  }
+
+  //----------------------------------------------------------------------------
+  band_engine::t_word * band_engine::get_row(const t_plane & p_plane,
+                                             const uint32_t & p_row)const
+  {
+    return m_data + (p_row / m_band_height) * (m_band_size / sizeof(t_word)) + ((size_t)(p_row % m_band_height) * 3 + (unsigned int)p_plane) * m_stride;
+  }
+
+  //----------------------------------------------------------------------------
+  bool band_engine::is_set(const t_plane & p_plane,
+                           const uint32_t & p_x,
+                           const uint32_t & p_y)const
+  {
+    return get_row(p_plane,p_y + 1)[1 + (p_x + 1) / 64] & (((t_word)1) << ((p_x + 1) % 64));
+  }
+
+  //----------------------------------------------------------------------------
+  void band_engine::set(const t_plane & p_plane,
+                        const wireworld_common::wireworld_types::t_coordinates & p_coordinates)
+  {
+    get_row(p_plane,p_coordinates.second + 1)[1 + (p_coordinates.first + 1) / 64] |= ((t_word)1) << ((p_coordinates.first + 1) % 64);
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t band_engine::get_nb_electron(void)const
+  {
+    return m_nb_electron;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t band_engine::get_nb_tail(void)const
+  {
+    return m_nb_tail;
+  }
+
+  //----------------------------------------------------------------------------
+  wireworld_common::wireworld_types::t_cell_state band_engine::get_state(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const
+    {
+      if(p_coordinates.first + 2 < m_width && p_coordinates.second + 2 < m_height)
+        {
+          if(is_set(t_plane::ELECTRON,p_coordinates.first,p_coordinates.second))
+            {
+              return wireworld_common::wireworld_types::t_cell_state::ELECTRON;
+            }
+          if(is_set(t_plane::TAIL,p_coordinates.first,p_coordinates.second))
+            {
+              return wireworld_common::wireworld_types::t_cell_state::TAIL;
+            }
+        }
+      return wireworld_common::wireworld_types::t_cell_state::COPPER;
+    }
+
+  //----------------------------------------------------------------------------
+  void band_engine::display_changes(display_if & p_display)
+  {
+    for(uint32_t l_band = 0 ; l_band < m_nb_bands ; ++l_band)
+      {
+        if(!m_changed_bands[l_band])
+          {
+            continue;
+          }
+        m_changed_bands[l_band] = 0;
+        uint32_t l_last_row = std::min((l_band + 1) * m_band_height,m_height - 1);
+        for(uint32_t l_row = std::max(l_band * m_band_height,(uint32_t)1) ; l_row < l_last_row ; ++l_row)
+          {
+            bitplane_engine::display_row(p_display,l_row - 1,get_row(t_plane::COPPER,l_row),get_row(t_plane::ELECTRON,l_row),get_row(t_plane::TAIL,l_row),m_nb_words);
+          }
+        release(l_band,l_band + 1);
+      }
+  }
+}
+#endif // BAND_ENGINE_H
+//EOF
@@ -0,0 +1,343 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef BATCH_ENGINE_H
+#define BATCH_ENGINE_H
+
+#include "cell_index.h"
+#include "wireworld_types.h"
+#include "quicky_exception.h"
+#include <vector>
+#include <sstream>
+#include <cassert>
+
+namespace wireworld_systemc
+{
+  // Simulate independent scenarios of a single layout in lockstep. Bit l of
+  // cell words is the state of cell in scenario l (lane), a cell owning 1,
+  // 2, 4 or 8 words so that 64 to 512 lanes advance per generation. Rule is
+  // evaluated with bit-sliced saturating counters over neighbour list of
+  // cell index, word loops having a constant length they are vectorised by
+  // compiler
+  class batch_engine
+  {
+  public:
+    typedef uint64_t t_word;
+
+    inline batch_engine(const cell_index & p_index,
+                        const unsigned int & p_nb_lanes);
+
+    inline unsigned int get_nb_lanes(void)const;
+    // Lanes [0,p_nb_lanes[ get states indexed by cell id, other lanes are
+    // only copper
+    inline void reset(const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                      const unsigned int & p_nb_lanes);
+    // Lanes [p_first_lane,get_nb_lanes()[ become only copper
+    inline void clear(const unsigned int & p_first_lane);
+    // Lane activity is only updated for electrons and tails
+    inline void set_state(const unsigned int & p_lane,
+                          const cell_index::t_cell_id & p_id,
+                          const wireworld_common::wireworld_types::t_cell_state & p_state);
+    // Compute next generation of all lanes
+    inline void step(void);
+
+    // Tell if lane contains an electron or a tail
+    inline bool is_active(const unsigned int & p_lane)const;
+    inline bool is_active(void)const;
+    inline wireworld_common::wireworld_types::t_cell_state get_state(const unsigned int & p_lane,
+                                                                      const cell_index::t_cell_id & p_id)const;
+    // Numbers of electrons and tails of every lane, indexed by lane
+    inline void get_nb_electron(std::vector<uint32_t> & p_nb_electron)const;
+    inline void get_nb_tail(std::vector<uint32_t> & p_nb_tail)const;
+  private:
+    // Mask of lanes [0,p_nb_lanes[
+    inline void get_lanes(const unsigned int & p_nb_lanes,
+                          std::vector<t_word> & p_lanes)const;
+    template <unsigned int NB_WORDS>
+      inline void step_words(void);
+    inline bool is_set(const std::vector<t_word> & p_plane,
+                       const unsigned int & p_lane,
+                       const cell_index::t_cell_id & p_id)const;
+    // Count set bits of every lane in a single pass over plane
+    inline void count(const std::vector<t_word> & p_plane,
+                      std::vector<uint32_t> & p_counts)const;
+
+    const cell_index & m_index;
+    unsigned int m_nb_words;
+
+    // Words of cell i are [i * m_nb_words,(i + 1) * m_nb_words[
+    std::vector<t_word> m_electron;
+    std::vector<t_word> m_tail;
+    std::vector<t_word> m_next_electron;
+    std::vector<t_word> m_next_tail;
+
+    // Lanes containing an electron or a tail
+    std::vector<t_word> m_active;
+  };
+
+  //----------------------------------------------------------------------------
+  batch_engine::batch_engine(const cell_index & p_index,
+                             const unsigned int & p_nb_lanes):
+    m_index(p_index),
+    m_nb_words(p_nb_lanes / 64)
+    {
+      if(p_nb_lanes % 64 || (1 != m_nb_words && 2 != m_nb_words && 4 != m_nb_words && 8 != m_nb_words))
+        {
+          std::stringstream l_stream;
+          l_stream << p_nb_lanes;
+          throw quicky_exception::quicky_runtime_exception("Unsupported number of lanes " + l_stream.str() + ", supported values are 64, 128, 256 and 512",__LINE__,__FILE__);
+        }
+      size_t l_size = (size_t)m_index.get_nb_cells() * m_nb_words;
+      m_electron.resize(l_size,0);
+      m_tail.resize(l_size,0);
+      m_next_electron.resize(l_size,0);
+      m_next_tail.resize(l_size,0);
+      m_active.resize(m_nb_words,0);
+    }
+
+  //----------------------------------------------------------------------------
+  unsigned int batch_engine::get_nb_lanes(void)const
+  {
+    return 64 * m_nb_words;
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_engine::reset(const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                           const unsigned int & p_nb_lanes)
+  {
+    assert(p_states.size() == m_index.get_nb_cells());
+    assert(p_nb_lanes <= get_nb_lanes());
+    std::vector<t_word> l_lanes;
+    get_lanes(p_nb_lanes,l_lanes);
+    bool l_active = false;
+    for(cell_index::t_cell_id l_id = 0 ; l_id < m_index.get_nb_cells() ; ++l_id)
+      {
+        bool l_electron = wireworld_common::wireworld_types::t_cell_state::ELECTRON == p_states[l_id];
+        bool l_tail = wireworld_common::wireworld_types::t_cell_state::TAIL == p_states[l_id];
+        l_active |= l_electron || l_tail;
+        for(unsigned int l_word = 0 ; l_word < m_nb_words ; ++l_word)
+          {
+            m_electron[l_id * m_nb_words + l_word] = l_electron ? l_lanes[l_word] : 0;
+            m_tail[l_id * m_nb_words + l_word] = l_tail ? l_lanes[l_word] : 0;
+          }
+      }
+    for(unsigned int l_word = 0 ; l_word < m_nb_words ; ++l_word)
+      {
+        m_active[l_word] = l_active ? l_lanes[l_word] : 0;
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_engine::clear(const unsigned int & p_first_lane)
+  {
+    assert(p_first_lane <= get_nb_lanes());
+    std::vector<t_word> l_lanes;
+    get_lanes(p_first_lane,l_lanes);
+    for(size_t l_index = 0 ; l_index < m_electron.size() ; ++l_index)
+      {
+        m_electron[l_index] &= l_lanes[l_index % m_nb_words];
+        m_tail[l_index] &= l_lanes[l_index % m_nb_words];
+      }
+    for(unsigned int l_word = 0 ; l_word < m_nb_words ; ++l_word)
+      {
+        m_active[l_word] &= l_lanes[l_word];
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_engine::set_state(const unsigned int & p_lane,
+                               const cell_index::t_cell_id & p_id,
+                               const wireworld_common::wireworld_types::t_cell_state & p_state)
+  {
+    assert(p_lane < get_nb_lanes());
+    assert(p_id < m_index.get_nb_cells());
+    size_t l_index = (size_t)p_id * m_nb_words + p_lane / 64;
+    t_word l_bit = ((t_word)1) << (p_lane % 64);
+    m_electron[l_index] &= ~l_bit;
+    m_tail[l_index] &= ~l_bit;
+    if(wireworld_common::wireworld_types::t_cell_state::ELECTRON == p_state)
+      {
+        m_electron[l_index] |= l_bit;
+        m_active[p_lane / 64] |= l_bit;
+      }
+    else if(wireworld_common::wireworld_types::t_cell_state::TAIL == p_state)
+      {
+        m_tail[l_index] |= l_bit;
+        m_active[p_lane / 64] |= l_bit;
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_engine::get_lanes(const unsigned int & p_nb_lanes,
+                               std::vector<t_word> & p_lanes)const
+  {
+    p_lanes.assign(m_nb_words,0);
+    for(unsigned int l_word = 0 ; l_word < m_nb_words && 64 * l_word < p_nb_lanes ; ++l_word)
+      {
+        p_lanes[l_word] = p_nb_lanes - 64 * l_word >= 64 ? ~((t_word)0) : (((t_word)1) << (p_nb_lanes - 64 * l_word)) - 1;
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_engine::step(void)
+  {
+    switch(m_nb_words)
+      {
+      case 1:
+        step_words<1>();
+        break;
+      case 2:
+        step_words<2>();
+        break;
+      case 4:
+        step_words<4>();
+        break;
+      case 8:
+        step_words<8>();
+        break;
+      default:
+        throw quicky_exception::quicky_logic_exception("Unexpected number of words per cell",__LINE__,__FILE__);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  template <unsigned int NB_WORDS>
+    void batch_engine::step_words(void)
+    {
+      t_word l_active[NB_WORDS] = {0};
+      for(cell_index::t_cell_id l_id = 0 ; l_id < m_index.get_nb_cells() ; ++l_id)
+        {
+          // Lanes where exactly one, exactly two and at least three
+          // neighbours are electrons. First two are only meaningful where
+          // third one is not set
+          t_word l_ones[NB_WORDS] = {0};
+          t_word l_twos[NB_WORDS] = {0};
+          t_word l_more[NB_WORDS] = {0};
+          const cell_index::t_cell_id * l_neighbours = m_index.get_neighbours(l_id);
+          for(unsigned int l_index = 0 ; l_index < m_index.get_nb_neighbours(l_id) ; ++l_index)
+            {
+              const t_word * l_neighbour = &m_electron[(size_t)l_neighbours[l_index] * NB_WORDS];
+              for(unsigned int l_word = 0 ; l_word < NB_WORDS ; ++l_word)
+                {
+                  t_word l_twos_before = l_twos[l_word];
+                  l_more[l_word] |= l_twos_before & l_neighbour[l_word];
+                  l_twos[l_word] = (l_twos_before & ~l_neighbour[l_word]) | (l_ones[l_word] & l_neighbour[l_word]);
+                  l_ones[l_word] ^= l_neighbour[l_word] & ~l_twos_before;
+                }
+            }
+          size_t l_offset = (size_t)l_id * NB_WORDS;
+          for(unsigned int l_word = 0 ; l_word < NB_WORDS ; ++l_word)
+            {
+              t_word l_electron = m_electron[l_offset + l_word];
+              t_word l_copper = ~(l_electron | m_tail[l_offset + l_word]);
+              m_next_electron[l_offset + l_word] = l_copper & (l_ones[l_word] | l_twos[l_word]) & ~l_more[l_word];
+              m_next_tail[l_offset + l_word] = l_electron;
+              l_active[l_word] |= m_next_electron[l_offset + l_word] | l_electron;
+            }
+        }
+      m_electron.swap(m_next_electron);
+      m_tail.swap(m_next_tail);
+      std::copy(l_active,l_active + NB_WORDS,m_active.begin());
+    }
+
+  //----------------------------------------------------------------------------
+  bool batch_engine::is_active(const unsigned int & p_lane)const
+  {
+    assert(p_lane < get_nb_lanes());
+    return (m_active[p_lane / 64] >> (p_lane % 64)) & 0x1;
+  }
+
+  //----------------------------------------------------------------------------
+  bool batch_engine::is_active(void)const
+  {
+    for(auto l_word: m_active)
+      {
+        if(l_word)
+          {
+            return true;
+          }
+      }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  wireworld_common::wireworld_types::t_cell_state batch_engine::get_state(const unsigned int & p_lane,
+                                                                           const cell_index::t_cell_id & p_id)const
+  {
+    if(is_set(m_electron,p_lane,p_id))
+      {
+        return wireworld_common::wireworld_types::t_cell_state::ELECTRON;
+      }
+    return is_set(m_tail,p_lane,p_id) ? wireworld_common::wireworld_types::t_cell_state::TAIL : wireworld_common::wireworld_types::t_cell_state::COPPER;
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_engine::get_nb_electron(std::vector<uint32_t> & p_nb_electron)const
+  {
+    count(m_electron,p_nb_electron);
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_engine::get_nb_tail(std::vector<uint32_t> & p_nb_tail)const
+  {
+    count(m_tail,p_nb_tail);
+  }
+
+  //----------------------------------------------------------------------------
+  bool batch_engine::is_set(const std::vector<t_word> & p_plane,
+                            const unsigned int & p_lane,
+                            const cell_index::t_cell_id & p_id)const
+  {
+    assert(p_lane < get_nb_lanes());
+    assert(p_id < m_index.get_nb_cells());
+    return (p_plane[(size_t)p_id * m_nb_words + p_lane / 64] >> (p_lane % 64)) & 0x1;
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_engine::count(const std::vector<t_word> & p_plane,
+                           std::vector<uint32_t> & p_counts)const
+  {
+    // Bit-sliced counters: bit l of slice b of word w is bit b of count of
+    // lane 64 * w + l. Cell words are added with a ripple carry that stops
+    // as soon as carry is null
+    std::vector<t_word> l_slices(32 * m_nb_words,0);
+    for(size_t l_index = 0 ; l_index < p_plane.size() ; ++l_index)
+      {
+        t_word * l_slice = &l_slices[32 * (l_index % m_nb_words)];
+        t_word l_carry = p_plane[l_index];
+        for(unsigned int l_bit = 0 ; l_carry ; ++l_bit)
+          {
+            assert(l_bit < 32);
+            t_word l_next_carry = l_slice[l_bit] & l_carry;
+            l_slice[l_bit] ^= l_carry;
+            l_carry = l_next_carry;
+          }
+      }
+    p_counts.assign(get_nb_lanes(),0);
+    for(unsigned int l_lane = 0 ; l_lane < get_nb_lanes() ; ++l_lane)
+      {
+        const t_word * l_slice = &l_slices[32 * (l_lane / 64)];
+        for(unsigned int l_bit = 0 ; l_bit < 32 ; ++l_bit)
+          {
+            p_counts[l_lane] |= ((uint32_t)(l_slice[l_bit] >> (l_lane % 64)) & 0x1) << l_bit;
+          }
+      }
+  }
+}
+#endif // BATCH_ENGINE_H
+//EOF
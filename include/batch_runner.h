@@ -0,0 +1,197 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include "batch_engine.h"
+#include "cell_index.h"
+#include "quicky_exception.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdio>
+
+namespace wireworld_systemc
+{
+  // Run scenarios listed in a file on layout, as many at once as there are
+  // lanes in batch engine. Each line of file is a scenario: blank separated
+  // list of "e:X,Y" and "t:X,Y" items setting cell (X,Y) to electron or tail
+  // on top of layout initial states. Empty lines and lines starting with '#'
+  // are ignored. Like other runners, simulation starts at generation of
+  // layout and a scenario ends at first generation without electron nor
+  // tail, or once maximum number of cycles is reached. One CSV line is written per
+  // scenario: its number, line in file, termination generation (empty if
+  // scenario is still alive), last generation and numbers of electrons and
+  // tails at last generation
+  class batch_runner
+  {
+  public:
+    inline batch_runner(const cell_index & p_index,
+                        const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                        const uint64_t & p_generation,
+                        const uint64_t & p_nb_max_cycle,
+                        const unsigned int & p_nb_lanes);
+    inline void run(const std::string & p_file_name,
+                    std::ostream & p_stream);
+  private:
+    // Set lane from a scenario line
+    inline void parse(const std::string & p_line,
+                      const unsigned int & p_line_number,
+                      const unsigned int & p_lane);
+    // Simulate lanes [0,p_nb_lanes[ and report them
+    inline void run_lanes(const unsigned int & p_nb_lanes,
+                          std::ostream & p_stream);
+
+    const cell_index & m_index;
+    const std::vector<wireworld_common::wireworld_types::t_cell_state> & m_states;
+    // Generation of m_states
+    const uint64_t m_generation;
+    const uint64_t m_nb_max_cycle;
+    batch_engine m_engine;
+    // Scenario number and file line of each lane
+    std::vector<uint64_t> m_scenarios;
+    std::vector<unsigned int> m_line_numbers;
+  };
+
+  //----------------------------------------------------------------------------
+  batch_runner::batch_runner(const cell_index & p_index,
+                             const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                             const uint64_t & p_generation,
+                             const uint64_t & p_nb_max_cycle,
+                             const unsigned int & p_nb_lanes):
+    m_index(p_index),
+    m_states(p_states),
+    m_generation(p_generation),
+    m_nb_max_cycle(p_nb_max_cycle),
+    m_engine(p_index,p_nb_lanes),
+    m_scenarios(p_nb_lanes,0),
+    m_line_numbers(p_nb_lanes,0)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  void batch_runner::run(const std::string & p_file_name,
+                         std::ostream & p_stream)
+  {
+    std::ifstream l_file(p_file_name.c_str());
+    if(!l_file.is_open())
+      {
+        throw quicky_exception::quicky_runtime_exception("Unable to open batch file \"" + p_file_name + "\"",__LINE__,__FILE__);
+      }
+    p_stream << "scenario,line,termination_generation,generation,electrons,tails" << std::endl ;
+    std::string l_line;
+    unsigned int l_line_number = 0;
+    uint64_t l_nb_scenarios = 0;
+    unsigned int l_nb_lanes = 0;
+    while(std::getline(l_file,l_line))
+      {
+        ++l_line_number;
+        if(l_line.find_first_not_of(" \t\r") == std::string::npos || '#' == l_line[l_line.find_first_not_of(" \t\r")])
+          {
+            continue;
+          }
+        if(!l_nb_lanes)
+          {
+            m_engine.reset(m_states,m_engine.get_nb_lanes());
+          }
+        parse(l_line,l_line_number,l_nb_lanes);
+        m_scenarios[l_nb_lanes] = l_nb_scenarios++;
+        m_line_numbers[l_nb_lanes] = l_line_number;
+        if(m_engine.get_nb_lanes() == ++l_nb_lanes)
+          {
+            run_lanes(l_nb_lanes,p_stream);
+            l_nb_lanes = 0;
+          }
+      }
+    if(l_nb_lanes)
+      {
+        // Unused lanes are cleared so that they do not delay end of batch
+        m_engine.clear(l_nb_lanes);
+        run_lanes(l_nb_lanes,p_stream);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_runner::parse(const std::string & p_line,
+                           const unsigned int & p_line_number,
+                           const unsigned int & p_lane)
+  {
+    std::stringstream l_stream(p_line);
+    std::string l_item;
+    while(l_stream >> l_item)
+      {
+        char l_type = 0;
+        uint32_t l_x = 0;
+        uint32_t l_y = 0;
+        char l_end = 0;
+        cell_index::t_cell_id l_id = 0;
+        if(3 != sscanf(l_item.c_str(),"%c:%u,%u%c",&l_type,&l_x,&l_y,&l_end) || ('e' != l_type && 't' != l_type) || !m_index.find(wireworld_common::wireworld_types::t_coordinates(l_x,l_y),l_id))
+          {
+            std::stringstream l_line_stream;
+            l_line_stream << p_line_number;
+            throw quicky_exception::quicky_runtime_exception("Bad item \"" + l_item + "\" at line " + l_line_stream.str() + " of batch file: expecting e:X,Y or t:X,Y with (X,Y) a copper cell",__LINE__,__FILE__);
+          }
+        m_engine.set_state(p_lane,l_id,'e' == l_type ? wireworld_common::wireworld_types::t_cell_state::ELECTRON : wireworld_common::wireworld_types::t_cell_state::TAIL);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void batch_runner::run_lanes(const unsigned int & p_nb_lanes,
+                               std::ostream & p_stream)
+  {
+    std::vector<uint64_t> l_terminations(p_nb_lanes,UINT64_MAX);
+    uint64_t l_generation = m_generation;
+    while(true)
+      {
+        for(unsigned int l_lane = 0 ; l_lane < p_nb_lanes ; ++l_lane)
+          {
+            if(UINT64_MAX == l_terminations[l_lane] && !m_engine.is_active(l_lane))
+              {
+                l_terminations[l_lane] = l_generation;
+              }
+          }
+        // Same condition as wireworld::clk_management and engine_runner::run:
+        // next generation is computed while it does not exceed maximum
+        // number of cycles
+        if(!m_engine.is_active() || l_generation + 1 > m_nb_max_cycle)
+          {
+            break;
+          }
+        m_engine.step();
+        ++l_generation;
+      }
+    std::vector<uint32_t> l_nb_electron;
+    std::vector<uint32_t> l_nb_tail;
+    m_engine.get_nb_electron(l_nb_electron);
+    m_engine.get_nb_tail(l_nb_tail);
+    for(unsigned int l_lane = 0 ; l_lane < p_nb_lanes ; ++l_lane)
+      {
+        p_stream << m_scenarios[l_lane] << "," << m_line_numbers[l_lane] << ",";
+        if(UINT64_MAX != l_terminations[l_lane])
+          {
+            p_stream << l_terminations[l_lane];
+          }
+        p_stream << "," << l_generation << "," << l_nb_electron[l_lane] << "," << l_nb_tail[l_lane] << std::endl ;
+      }
+  }
+}
+#endif // BATCH_RUNNER_H
+//EOF
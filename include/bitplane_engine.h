@@ -0,0 +1,460 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef BITPLANE_ENGINE_H
+#define BITPLANE_ENGINE_H
+
+#include "engine_if.h"
+#include "cell_index.h"
+#include "quicky_exception.h"
+#include "word_pack.h"
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include <cassert>
+
+namespace wireworld_systemc
+{
+  // Engine storing copper, electron and tail states as bitplanes: one bit per
+  // board position, 64 positions per word. Rule of cell<SIZE>::run is
+  // evaluated for a whole word at once with bit-sliced saturating counters.
+  // Words of a row are processed by packs of simd_pack, so 4 words at once
+  // when compiled for AVX2 and 2 words with SSE2
+  class bitplane_engine: public engine_if
+  {
+  public:
+    inline bitplane_engine(const cell_index & p_index,
+                           const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states);
+
+    // Methods inherited from engine_if
+    inline void step(void);
+    inline uint32_t get_nb_electron(void)const;
+    inline uint32_t get_nb_tail(void)const;
+    inline wireworld_common::wireworld_types::t_cell_state get_state(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const;
+    inline void display_changes(display_if & p_display);
+    // End of methods inherited from engine_if
+
+    // Check that neighbours are the copper cells of Moore neighbourhood as
+    // bitplane evaluation relies on it
+    inline static void check_topology(const cell_index & p_index,
+                                      const std::string & p_engine_name);
+
+    typedef uint64_t t_word;
+
+    // Rows read and written to compute next generation of a row, they are
+    // surrounded by one zero word on each side
+    typedef struct
+    {
+      const t_word * m_up;
+      const t_word * m_middle;
+      const t_word * m_down;
+      const t_word * m_copper;
+      const t_word * m_tail;
+      t_word * m_next_electron;
+      t_word * m_next_tail;
+    } t_row;
+
+    // Compute next electrons and tails of words [1,p_nb_words] of a row.
+    // Return true if row contains electrons in current or next generation
+    inline static bool step_row(const t_row & p_row,
+                                const uint32_t & p_nb_words);
+    inline static uint32_t count(const t_word * p_words,
+                                 const uint32_t & p_nb_words);
+    // Draw copper cells of row p_y
+    inline static void display_row(display_if & p_display,
+                                   const uint32_t & p_y,
+                                   const t_word * p_copper,
+                                   const t_word * p_electron,
+                                   const t_word * p_tail,
+                                   const uint32_t & p_nb_words);
+  protected:
+    // Compute next generation of rows [p_first_row,p_last_row[ and return
+    // number of electrons it contains. Rows 0 and m_height - 1 are margins.
+    // Only current planes are read so distinct rows can be computed
+    // concurrently
+    inline uint32_t step_rows(const uint32_t & p_first_row, const uint32_t & p_last_row);
+    // Next generation becomes current one
+    inline void end_step(const uint32_t & p_nb_electron);
+    inline const uint32_t & get_height(void)const;
+  private:
+    // Compute words [p_first_word,p_last_word[ by packs of PACK
+    template <class PACK>
+    inline static bool step_words(const t_row & p_row,
+                                  const uint32_t & p_first_word,
+                                  const uint32_t & p_last_word);
+
+    inline size_t get_word_index(const uint32_t & p_x, const uint32_t & p_y)const;
+    inline t_word get_bit(const uint32_t & p_x)const;
+    inline void set(std::vector<t_word> & p_plane, const wireworld_common::wireworld_types::t_coordinates & p_coordinates);
+    inline bool is_set(const std::vector<t_word> & p_plane, const uint32_t & p_x, const uint32_t & p_y)const;
+
+    // Position (x,y) is bit x + 1 of row y + 1. Each row is surrounded by
+    // one zero word on each side and first and last rows stay empty so that
+    // neighbours of any cell can be read without bound checks
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_nb_words;
+    uint32_t m_stride;
+
+    std::vector<t_word> m_copper;
+    std::vector<t_word> m_electron;
+    std::vector<t_word> m_tail;
+    std::vector<t_word> m_next_electron;
+    std::vector<t_word> m_next_tail;
+
+    // Rows containing an electron or a tail in current and next planes.
+    // Rows around which nothing is active are skipped
+    std::vector<uint8_t> m_active_rows;
+    std::vector<uint8_t> m_next_active_rows;
+    // Rows having changed since last display
+    std::vector<uint8_t> m_changed_rows;
+
+    uint32_t m_nb_electron;
+    uint32_t m_nb_tail;
+  };
+
+  //----------------------------------------------------------------------------
+  bitplane_engine::bitplane_engine(const cell_index & p_index,
+                                   const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states):
+    m_width(0),
+    m_height(0),
+    m_nb_words(0),
+    m_stride(0),
+    m_nb_electron(0),
+    m_nb_tail(0)
+    {
+      check_topology(p_index,"bitplane");
+
+      uint32_t l_x_max = 0;
+      uint32_t l_y_max = 0;
+      for(cell_index::t_cell_id l_id = 0 ; l_id < p_index.get_nb_cells() ; ++l_id)
+        {
+          if(p_index.get_coordinates(l_id).first > l_x_max) l_x_max = p_index.get_coordinates(l_id).first;
+          if(p_index.get_coordinates(l_id).second > l_y_max) l_y_max = p_index.get_coordinates(l_id).second;
+        }
+      m_width = l_x_max + 3;
+      m_height = l_y_max + 3;
+      m_nb_words = (m_width + 63) / 64;
+      m_stride = m_nb_words + 2;
+
+      size_t l_size = ((size_t)m_stride) * m_height;
+      m_copper.resize(l_size,0);
+      m_electron.resize(l_size,0);
+      m_tail.resize(l_size,0);
+      m_next_electron.resize(l_size,0);
+      m_next_tail.resize(l_size,0);
+      m_active_rows.resize(m_height,0);
+      m_next_active_rows.resize(m_height,0);
+      m_changed_rows.resize(m_height,1);
+
+      for(cell_index::t_cell_id l_id = 0 ; l_id < p_index.get_nb_cells() ; ++l_id)
+        {
+          const wireworld_common::wireworld_types::t_coordinates & l_coordinates = p_index.get_coordinates(l_id);
+          set(m_copper,l_coordinates);
+          switch(p_states[l_id])
+            {
+            case wireworld_common::wireworld_types::t_cell_state::ELECTRON:
+              set(m_electron,l_coordinates);
+              ++m_nb_electron;
+              m_active_rows[l_coordinates.second + 1] = 1;
+              break;
+            case wireworld_common::wireworld_types::t_cell_state::TAIL:
+              set(m_tail,l_coordinates);
+              ++m_nb_tail;
+              m_active_rows[l_coordinates.second + 1] = 1;
+              break;
+            default:
+              break;
+            }
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  void bitplane_engine::step(void)
+  {
+    end_step(step_rows(1,m_height - 1));
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t bitplane_engine::step_rows(const uint32_t & p_first_row, const uint32_t & p_last_row)
+  {
+    uint32_t l_nb_electron = 0;
+    for(uint32_t l_row = p_first_row ; l_row < p_last_row ; ++l_row)
+      {
+        size_t l_row_start = ((size_t)l_row) * m_stride;
+        if(!m_active_rows[l_row - 1] && !m_active_rows[l_row] && !m_active_rows[l_row + 1])
+          {
+            // Nothing can happen here: just clear what remains from two
+            // generations ago
+            if(m_next_active_rows[l_row])
+              {
+                std::fill(m_next_electron.begin() + l_row_start,m_next_electron.begin() + l_row_start + m_stride,0);
+                std::fill(m_next_tail.begin() + l_row_start,m_next_tail.begin() + l_row_start + m_stride,0);
+                m_next_active_rows[l_row] = 0;
+              }
+            continue;
+          }
+
+        t_row l_row_words;
+        l_row_words.m_up = &m_electron[l_row_start - m_stride];
+        l_row_words.m_middle = &m_electron[l_row_start];
+        l_row_words.m_down = &m_electron[l_row_start + m_stride];
+        l_row_words.m_copper = &m_copper[l_row_start];
+        l_row_words.m_tail = &m_tail[l_row_start];
+        l_row_words.m_next_electron = &m_next_electron[l_row_start];
+        l_row_words.m_next_tail = &m_next_tail[l_row_start];
+        m_next_active_rows[l_row] = step_row(l_row_words,m_nb_words);
+        // Electrons and tails of a row always change
+        m_changed_rows[l_row] |= m_active_rows[l_row] | m_next_active_rows[l_row];
+        if(m_next_active_rows[l_row])
+          {
+            l_nb_electron += count(l_row_words.m_next_electron + 1,m_nb_words);
+          }
+      }
+    return l_nb_electron;
+  }
+
+  //----------------------------------------------------------------------------
+  bool bitplane_engine::step_row(const t_row & p_row,
+                                 const uint32_t & p_nb_words)
+  {
+    uint32_t l_last_pack_word = 1 + p_nb_words - p_nb_words % simd_pack::m_nb_words;
+    bool l_active = step_words<simd_pack>(p_row,1,l_last_pack_word);
+    return step_words<scalar_pack>(p_row,l_last_pack_word,p_nb_words + 1) || l_active;
+  }
+
+  //----------------------------------------------------------------------------
+  template <class PACK>
+  bool bitplane_engine::step_words(const t_row & p_row,
+                                   const uint32_t & p_first_word,
+                                   const uint32_t & p_last_word)
+  {
+    typename PACK::t_pack l_activity = PACK::zero();
+    for(uint32_t l_word = p_first_word ; l_word < p_last_word ; l_word += PACK::m_nb_words)
+      {
+        // Eight neighbour planes: bit of position x - 1 is shifted to
+        // position x for left neighbours and conversely for right ones.
+        // Carries come from the unaligned packs starting one word before and
+        // one word after
+        typename PACK::t_pack l_up = PACK::load(p_row.m_up + l_word);
+        typename PACK::t_pack l_middle = PACK::load(p_row.m_middle + l_word);
+        typename PACK::t_pack l_down = PACK::load(p_row.m_down + l_word);
+        typename PACK::t_pack l_neighbours[8] =
+          {
+            PACK::bit_or(PACK::shift_left(l_up,1),PACK::shift_right(PACK::load(p_row.m_up + l_word - 1),63)),
+            l_up,
+            PACK::bit_or(PACK::shift_right(l_up,1),PACK::shift_left(PACK::load(p_row.m_up + l_word + 1),63)),
+            PACK::bit_or(PACK::shift_left(l_middle,1),PACK::shift_right(PACK::load(p_row.m_middle + l_word - 1),63)),
+            PACK::bit_or(PACK::shift_right(l_middle,1),PACK::shift_left(PACK::load(p_row.m_middle + l_word + 1),63)),
+            PACK::bit_or(PACK::shift_left(l_down,1),PACK::shift_right(PACK::load(p_row.m_down + l_word - 1),63)),
+            l_down,
+            PACK::bit_or(PACK::shift_right(l_down,1),PACK::shift_left(PACK::load(p_row.m_down + l_word + 1),63))
+          };
+
+        // Bit-sliced saturating counter telling if there are at least
+        // one, two or three electrons around each position
+        typename PACK::t_pack l_at_least_1 = PACK::zero();
+        typename PACK::t_pack l_at_least_2 = PACK::zero();
+        typename PACK::t_pack l_at_least_3 = PACK::zero();
+        for(unsigned int l_index = 0 ; l_index < 8 ; ++l_index)
+          {
+            l_at_least_3 = PACK::bit_or(l_at_least_3,PACK::bit_and(l_at_least_2,l_neighbours[l_index]));
+            l_at_least_2 = PACK::bit_or(l_at_least_2,PACK::bit_and(l_at_least_1,l_neighbours[l_index]));
+            l_at_least_1 = PACK::bit_or(l_at_least_1,l_neighbours[l_index]);
+          }
+
+        typename PACK::t_pack l_electron = PACK::and_not(PACK::and_not(PACK::and_not(PACK::bit_and(PACK::load(p_row.m_copper + l_word),l_at_least_1),l_at_least_3),l_middle),PACK::load(p_row.m_tail + l_word));
+        PACK::store(p_row.m_next_electron + l_word,l_electron);
+        PACK::store(p_row.m_next_tail + l_word,l_middle);
+        l_activity = PACK::bit_or(l_activity,PACK::bit_or(l_electron,l_middle));
+      }
+    return !PACK::is_zero(l_activity);
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t bitplane_engine::count(const t_word * p_words,
+                                  const uint32_t & p_nb_words)
+  {
+    uint32_t l_count = 0;
+    for(uint32_t l_word = 0 ; l_word < p_nb_words ; ++l_word)
+      {
+        l_count += __builtin_popcountll(p_words[l_word]);
+      }
+    return l_count;
+  }
+
+  //----------------------------------------------------------------------------
+  void bitplane_engine::end_step(const uint32_t & p_nb_electron)
+  {
+    m_electron.swap(m_next_electron);
+    m_tail.swap(m_next_tail);
+    m_active_rows.swap(m_next_active_rows);
+    m_nb_tail = m_nb_electron;
+    m_nb_electron = p_nb_electron;
+  }
+
+  //----------------------------------------------------------------------------
+  const uint32_t & bitplane_engine::get_height(void)const
+    {
+      return m_height;
+    }
+
+  //----------------------------------------------------------------------------
+  uint32_t bitplane_engine::get_nb_electron(void)const
+  {
+    return m_nb_electron;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t bitplane_engine::get_nb_tail(void)const
+  {
+    return m_nb_tail;
+  }
+
+  //----------------------------------------------------------------------------
+  wireworld_common::wireworld_types::t_cell_state bitplane_engine::get_state(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const
+    {
+      if(p_coordinates.first + 2 < m_width && p_coordinates.second + 2 < m_height)
+        {
+          if(is_set(m_electron,p_coordinates.first,p_coordinates.second))
+            {
+              return wireworld_common::wireworld_types::t_cell_state::ELECTRON;
+            }
+          if(is_set(m_tail,p_coordinates.first,p_coordinates.second))
+            {
+              return wireworld_common::wireworld_types::t_cell_state::TAIL;
+            }
+        }
+      return wireworld_common::wireworld_types::t_cell_state::COPPER;
+    }
+
+  //----------------------------------------------------------------------------
+  void bitplane_engine::display_changes(display_if & p_display)
+  {
+    for(uint32_t l_row = 1 ; l_row + 1 < m_height ; ++l_row)
+      {
+        if(m_changed_rows[l_row])
+          {
+            m_changed_rows[l_row] = 0;
+            size_t l_row_start = ((size_t)l_row) * m_stride;
+            display_row(p_display,l_row - 1,&m_copper[l_row_start],&m_electron[l_row_start],&m_tail[l_row_start],m_nb_words);
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void bitplane_engine::display_row(display_if & p_display,
+                                    const uint32_t & p_y,
+                                    const t_word * p_copper,
+                                    const t_word * p_electron,
+                                    const t_word * p_tail,
+                                    const uint32_t & p_nb_words)
+  {
+    for(uint32_t l_word = 1 ; l_word <= p_nb_words ; ++l_word)
+      {
+        t_word l_copper = p_copper[l_word];
+        while(l_copper)
+          {
+            unsigned int l_bit = __builtin_ctzll(l_copper);
+            l_copper &= l_copper - 1;
+            t_word l_mask = ((t_word)1) << l_bit;
+            wireworld_common::wireworld_types::t_cell_state l_state = wireworld_common::wireworld_types::t_cell_state::COPPER;
+            if(p_electron[l_word] & l_mask)
+              {
+                l_state = wireworld_common::wireworld_types::t_cell_state::ELECTRON;
+              }
+            else if(p_tail[l_word] & l_mask)
+              {
+                l_state = wireworld_common::wireworld_types::t_cell_state::TAIL;
+              }
+            // Bit b of word w is position x + 1
+            p_display.display_cell((l_word - 1) * 64 + l_bit - 1,p_y,l_state);
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void bitplane_engine::check_topology(const cell_index & p_index,
+                                       const std::string & p_engine_name)
+  {
+    for(cell_index::t_cell_id l_id = 0 ; l_id < p_index.get_nb_cells() ; ++l_id)
+      {
+        const wireworld_common::wireworld_types::t_coordinates & l_coordinates = p_index.get_coordinates(l_id);
+        unsigned int l_nb_neighbours = 0;
+        cell_index::t_cell_id l_neighbour_id;
+        for(int l_delta_y = -1 ; l_delta_y <= 1 ; ++l_delta_y)
+          {
+            for(int l_delta_x = -1 ; l_delta_x <= 1 ; ++l_delta_x)
+              {
+                if((l_delta_x || l_delta_y) &&
+                   (l_delta_x >= 0 || l_coordinates.first) &&
+                   (l_delta_y >= 0 || l_coordinates.second) &&
+                   p_index.find(wireworld_common::wireworld_types::t_coordinates(l_coordinates.first + l_delta_x,l_coordinates.second + l_delta_y),l_neighbour_id))
+                  {
+                    ++l_nb_neighbours;
+                  }
+              }
+          }
+        bool l_ok = l_nb_neighbours == p_index.get_nb_neighbours(l_id);
+        const cell_index::t_cell_id * l_neighbours = p_index.get_neighbours(l_id);
+        for(unsigned int l_index = 0 ; l_index < p_index.get_nb_neighbours(l_id) ; ++l_index)
+          {
+            const wireworld_common::wireworld_types::t_coordinates & l_neighbour = p_index.get_coordinates(l_neighbours[l_index]);
+            l_ok &= l_neighbours[l_index] != l_id &&
+              std::abs((int64_t)l_neighbour.first - (int64_t)l_coordinates.first) <= 1 &&
+              std::abs((int64_t)l_neighbour.second - (int64_t)l_coordinates.second) <= 1;
+          }
+        if(!l_ok)
+          {
+            std::stringstream l_stream;
+            l_stream << "(" << l_coordinates.first << "," << l_coordinates.second << ")";
+            throw quicky_exception::quicky_logic_exception("Neighbours of cell " + l_stream.str() + " are not its Moore neighbourhood, this is not supported by " + p_engine_name + " engine",__LINE__,__FILE__);
+          }
+        if(!((l_id + 1) % cell_index::m_release_interval)) p_index.release_pages();
+      }
+    p_index.release_pages();
+  }
+
+  //----------------------------------------------------------------------------
+  size_t bitplane_engine::get_word_index(const uint32_t & p_x, const uint32_t & p_y)const
+  {
+    return ((size_t)(p_y + 1)) * m_stride + 1 + (p_x + 1) / 64;
+  }
+
+  //----------------------------------------------------------------------------
+  bitplane_engine::t_word bitplane_engine::get_bit(const uint32_t & p_x)const
+  {
+    return ((t_word)1) << ((p_x + 1) % 64);
+  }
+
+  //----------------------------------------------------------------------------
+  void bitplane_engine::set(std::vector<t_word> & p_plane, const wireworld_common::wireworld_types::t_coordinates & p_coordinates)
+  {
+    p_plane[get_word_index(p_coordinates.first,p_coordinates.second)] |= get_bit(p_coordinates.first);
+  }
+
+  //----------------------------------------------------------------------------
+  bool bitplane_engine::is_set(const std::vector<t_word> & p_plane, const uint32_t & p_x, const uint32_t & p_y)const
+  {
+    return p_plane[get_word_index(p_x,p_y)] & get_bit(p_x);
+  }
+}
+#endif // BITPLANE_ENGINE_H
+//EOF
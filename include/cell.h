@@ -22,11 +22,15 @@
 #include "systemc.h"
 #include "wireworld_types.h"
 #include "cell_base.h"
+#include "cell_index.h"
+#include "cell_transition.h"
+#include "period_detector.h"
 #include "quicky_exception.h"
-#include "wireworld_gui.h"
+#include "display_if.h"
 #include <vector>
 #include <string>
 #include <sstream>
+#include <type_traits>
 
 namespace wireworld_systemc
 {
@@ -37,63 +41,79 @@ namespace wireworld_systemc
   public:
     SC_HAS_PROCESS(cell);
     inline cell(sc_module_name p_name,
-		const std::vector<wireworld_common::wireworld_types::t_coordinates> & p_neighbour_coordinates,
+                const cell_index & p_index,
+                const cell_index::t_cell_id & p_id,
                 const wireworld_common::wireworld_types::t_cell_state & p_state,
-                const unsigned int & p_x,
-                const unsigned int & p_y,
-                wireworld_common::wireworld_gui * p_gui,
-               unsigned int & p_nb_electron);
+                display_if * p_display,
+               unsigned int & p_nb_electron,
+                uint64_t * p_hash);
 
     // Virtual methods to implement
     inline void bind_clk(sc_signal<bool> & p_clk);
     inline void bind_neighbour(sc_signal<bool> & p_neighbour, const unsigned int & p_index);
     inline void bind_electron(sc_signal<bool> & p_electron);
+    inline const wireworld_common::wireworld_types::t_cell_state & get_state(void)const;
     // End of virtual methods to implement
 
-    inline ~cell(void);
+  private:
+    // Cells having at most two neighbours are wire ends, straight wires or
+    // corners: they cannot see three electrons so telling if a neighbour is
+    // an electron is enough. They read neighbour signals directly, without
+    // going through port interface. Other cells count electrons of their
+    // ports
+    typedef std::integral_constant<bool,SIZE <= 2> t_is_wire;
+    typedef typename std::conditional<t_is_wire::value,const sc_signal<bool> *,sc_in<bool>>::type t_neighbour;
+  public:
     sc_in<bool> m_clk;
-    sc_in<bool> *m_neighbours[SIZE];
+    // Neighbours are held inline so that a cell is a single allocation
+    t_neighbour m_neighbours[SIZE];
     sc_out<bool> m_electron;
     
     inline void run(void);
   private:
+    inline void bind_neighbour(sc_signal<bool> & p_neighbour,
+                               const unsigned int & p_index,
+                               std::true_type);
+    inline void bind_neighbour(sc_signal<bool> & p_neighbour,
+                               const unsigned int & p_index,
+                               std::false_type);
+    inline unsigned int count_electrons(std::true_type)const;
+    inline unsigned int count_electrons(std::false_type)const;
+
     wireworld_common::wireworld_types::t_cell_state m_state;
     const unsigned int m_x;
     const unsigned int m_y;
-    wireworld_common::wireworld_gui * m_gui;
+    display_if * m_display;
     unsigned int & m_nb_electron;
+    // Board hash used by period detection, null when disabled
+    uint64_t * m_hash;
   };
 
 
   //----------------------------------------------------------------------------
   template <unsigned int SIZE>
     cell<SIZE>::cell(sc_module_name p_name,
-		     const std::vector<wireworld_common::wireworld_types::t_coordinates> & p_neighbour_coordinates,
+                     const cell_index & p_index,
+                     const cell_index::t_cell_id & p_id,
                      const wireworld_common::wireworld_types::t_cell_state & p_state,
-                     const unsigned int & p_x,
-                     const unsigned int & p_y,
-                     wireworld_common::wireworld_gui * p_gui,
-                     unsigned int & p_nb_electron):
+                     display_if * p_display,
+                     unsigned int & p_nb_electron,
+                     uint64_t * p_hash):
     sc_module(p_name),
     m_clk("clk"),
     m_electron("electron"),
     m_state(p_state),
-    m_x(p_x),
-    m_y(p_y),
-    m_gui(p_gui),
-    m_nb_electron(p_nb_electron)
+    m_x(p_index.get_coordinates(p_id).first),
+    m_y(p_index.get_coordinates(p_id).second),
+    m_display(p_display),
+    m_nb_electron(p_nb_electron),
+    m_hash(p_hash)
     {
-      assert(SIZE == p_neighbour_coordinates.size());
-      unsigned int l_index = 0;
-      for(auto l_iter:p_neighbour_coordinates)
-	{
-          std::stringstream l_stream;
-          l_stream << "from_" << l_iter.first << "_" << l_iter.second ;
-	  m_neighbours[l_index] = new sc_in<bool>(l_stream.str().c_str());
-          ++l_index;
-	}
-
-      if(m_gui) m_gui->displayCell(m_x,m_y,m_state);
+      assert(SIZE == p_index.get_nb_neighbours(p_id));
+
+#ifndef WIREWORLD_HEADLESS
+      if(m_display) m_display->display_cell(m_x,m_y,m_state);
+#endif // WIREWORLD_HEADLESS
 
       SC_METHOD(run);
       dont_initialize();
@@ -102,27 +122,34 @@ namespace wireworld_systemc
 
   //----------------------------------------------------------------------------
   template <unsigned int SIZE>
-    cell<SIZE>::~cell(void)
+    void cell<SIZE>::bind_clk(sc_signal<bool> & p_clk)
     {
-      for(unsigned int l_index = 0 ; l_index < SIZE ; ++l_index)
-	{
-	  delete m_neighbours[l_index];
-	}
+      m_clk(p_clk);
+    }
+  //----------------------------------------------------------------------------
+  template <unsigned int SIZE>
+    void cell<SIZE>::bind_neighbour(sc_signal<bool> & p_neighbour, const unsigned int & p_index)
+    {
+      assert(p_index < SIZE);
+      bind_neighbour(p_neighbour,p_index,t_is_wire());
     }
 
   //----------------------------------------------------------------------------
   template <unsigned int SIZE>
-    void cell<SIZE>::bind_clk(sc_signal<bool> & p_clk)
+    void cell<SIZE>::bind_neighbour(sc_signal<bool> & p_neighbour,
+                                    const unsigned int & p_index,
+                                    std::true_type)
     {
-      m_clk(p_clk);
+      m_neighbours[p_index] = &p_neighbour;
     }
+
   //----------------------------------------------------------------------------
   template <unsigned int SIZE>
-    void cell<SIZE>::bind_neighbour(sc_signal<bool> & p_neighbour, const unsigned int & p_index)
+    void cell<SIZE>::bind_neighbour(sc_signal<bool> & p_neighbour,
+                                    const unsigned int & p_index,
+                                    std::false_type)
     {
-      assert(p_index < SIZE);
-      assert(m_neighbours[p_index]);
-      (*m_neighbours[p_index])(p_neighbour);
+      m_neighbours[p_index](p_neighbour);
     }
   //----------------------------------------------------------------------------
   template <unsigned int SIZE>
@@ -131,53 +158,65 @@ namespace wireworld_systemc
       m_electron(p_electron);
     }
 
+  //----------------------------------------------------------------------------
+  template <unsigned int SIZE>
+    const wireworld_common::wireworld_types::t_cell_state & cell<SIZE>::get_state(void)const
+    {
+      return m_state;
+    }
+
   //----------------------------------------------------------------------------
   template <unsigned int SIZE>
     void cell<SIZE>::run(void)
     {
-      switch(m_state)
-	{
-	case wireworld_common::wireworld_types::t_cell_state::COPPER:
-	  {
-	    unsigned int l_total = 0;
-	    for(unsigned int l_index = 0 ; l_index < SIZE ; ++l_index)
-	      {
-		l_total += m_neighbours[l_index]->read();
-	      }
-	    if(l_total && l_total < 3)
-	      {
-		m_electron.write(1);
-		m_state = wireworld_common::wireworld_types::t_cell_state::ELECTRON;
-                if(m_gui) m_gui->displayElectron(m_x,m_y);
-                ++m_nb_electron;
-#ifdef DEBUG_MESSAGES
-                std::cout << "Cell(" << m_x << "," << m_y << ") switch to " << wireworld_common::wireworld_types::cell_state2string(m_state) << " @" << sc_time_stamp() << std::endl ;
-#endif //DEBUG_MESSAGES
-	      }
-	  }
-	  break;
-	case wireworld_common::wireworld_types::t_cell_state::TAIL:
-	  m_state = wireworld_common::wireworld_types::t_cell_state::COPPER;
-          if(m_gui) m_gui->displayCopper(m_x,m_y);
+      wireworld_common::wireworld_types::t_cell_state l_state = cell_transition<SIZE>::get_next(m_state,count_electrons(t_is_wire()));
+      bool l_electron = wireworld_common::wireworld_types::t_cell_state::ELECTRON == l_state;
+      m_nb_electron += l_electron;
+      // Port is only written when electron flag changes
+      if(l_electron != (wireworld_common::wireworld_types::t_cell_state::ELECTRON == m_state))
+        {
+          m_electron.write(l_electron);
+        }
+      // Hash and display of changes are the only work depending on them
+      if((m_hash || m_display) && l_state != m_state)
+        {
+          if(m_hash) period_detector::update(*m_hash,m_x,m_y,m_state,l_state);
+#ifndef WIREWORLD_HEADLESS
+          if(m_display) m_display->display_cell(m_x,m_y,l_state);
+#endif // WIREWORLD_HEADLESS
+        }
 #ifdef DEBUG_MESSAGES
-          std::cout << "Cell(" << m_x << "," << m_y << ") switch to " << wireworld_common::wireworld_types::cell_state2string(m_state) << " @" << sc_time_stamp()  << std::endl ;
+      if(l_state != m_state)
+        {
+          std::cout << "Cell(" << m_x << "," << m_y << ") switch to " << wireworld_common::wireworld_types::cell_state2string(l_state) << " @" << sc_time_stamp() << std::endl ;
+        }
 #endif // DEBUG_MESSAGES
-	  break;
-	case wireworld_common::wireworld_types::t_cell_state::ELECTRON:
-	  m_electron.write(0);
-	  m_state = wireworld_common::wireworld_types::t_cell_state::TAIL;
-          if(m_gui) m_gui->displayTail(m_x,m_y);
-#ifdef DEBUG_MESSAGES
-          std::cout << "Cell(" << m_x << "," << m_y << ") switch to " << wireworld_common::wireworld_types::cell_state2string(m_state) << " @" << sc_time_stamp()  << std::endl ;
-#endif // DEBUG_MESSAGES
-	  break;
-        default:
-	  {
-	    std::stringstream l_stream;
-	    l_stream << (unsigned int) m_state ;
-	    throw quicky_exception::quicky_logic_exception("Unknown state value : "+l_stream.str(),__LINE__,__FILE__);
-	  }
-	}
+      m_state = l_state;
+    }
+
+  //----------------------------------------------------------------------------
+  template <unsigned int SIZE>
+    unsigned int cell<SIZE>::count_electrons(std::true_type)const
+    {
+      // Qualified call is resolved at compile time
+      bool l_electron = false;
+      for(unsigned int l_index = 0 ; l_index < SIZE ; ++l_index)
+        {
+          l_electron |= m_neighbours[l_index]->sc_signal<bool>::read();
+        }
+      return l_electron;
+    }
+
+  //----------------------------------------------------------------------------
+  template <unsigned int SIZE>
+    unsigned int cell<SIZE>::count_electrons(std::false_type)const
+    {
+      unsigned int l_total = 0;
+      for(unsigned int l_index = 0 ; l_index < SIZE ; ++l_index)
+        {
+          l_total += m_neighbours[l_index].read();
+        }
+      return l_total;
     }
 
 }
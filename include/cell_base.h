@@ -20,6 +20,7 @@
 #define CELL_BASE_H
 
 #include "systemc.h"
+#include "wireworld_types.h"
 
 namespace wireworld_systemc
 {
@@ -30,6 +31,7 @@ namespace wireworld_systemc
     virtual void bind_clk(sc_signal<bool> & p_clk)=0;
     virtual void bind_neighbour(sc_signal<bool> & p_neighbour, const unsigned int & p_index)=0;
     virtual void bind_electron(sc_signal<bool> & p_electron)=0;
+    virtual const wireworld_common::wireworld_types::t_cell_state & get_state(void)const=0;
     virtual ~cell_base(void){}
   private:
   };
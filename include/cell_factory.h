@@ -21,6 +21,7 @@
 
 #include "systemc.h"
 #include "cell.h"
+#include "arena.h"
 
 namespace wireworld_systemc
 {
@@ -28,58 +29,60 @@ namespace wireworld_systemc
   {
   public:
     inline static cell_base * create(sc_module_name p_name,
-                                     const std::vector<wireworld_common::wireworld_types::t_coordinates> & p_neighbour_coordinates,
+                                     const cell_index & p_index,
+                                     const cell_index::t_cell_id & p_id,
                                      const wireworld_common::wireworld_types::t_cell_state & p_state,
-                                     const unsigned int & p_x,
-                                     const unsigned int & p_y,
-                                     wireworld_common::wireworld_gui * p_gui,
-                                     unsigned int & p_nb_electron);  
+                                     display_if * p_display,
+                                     unsigned int & p_nb_electron,
+                                     uint64_t * p_hash,
+                                     arena & p_arena);  
   private:
   };
 
   //----------------------------------------------------------------------------
   cell_base * cell_factory::create(sc_module_name p_name,
-                                   const std::vector<wireworld_common::wireworld_types::t_coordinates> & p_neighbour_coordinates,
+                                   const cell_index & p_index,
+                                   const cell_index::t_cell_id & p_id,
                                    const wireworld_common::wireworld_types::t_cell_state & p_state,
-                                   const unsigned int & p_x,
-                                   const unsigned int & p_y,
-                                   wireworld_common::wireworld_gui * p_gui,
-                                   unsigned int & p_nb_electron)
+                                   display_if * p_display,
+                                   unsigned int & p_nb_electron,
+                                   uint64_t * p_hash,
+                                   arena & p_arena)
     {
-      switch(p_neighbour_coordinates.size())
+      switch(p_index.get_nb_neighbours(p_id))
 	{
 	case 1:
-	  return new cell<1>(p_name, p_neighbour_coordinates, p_state, p_x, p_y, p_gui, p_nb_electron);
+	  return p_arena.create<cell<1>>(p_name, p_index, p_id, p_state, p_display, p_nb_electron, p_hash);
 	  break;
 	case 2:
-	  return new cell<2>(p_name, p_neighbour_coordinates, p_state, p_x, p_y, p_gui, p_nb_electron);
+	  return p_arena.create<cell<2>>(p_name, p_index, p_id, p_state, p_display, p_nb_electron, p_hash);
 	  break;
 	case 3:
-	  return new cell<3>(p_name, p_neighbour_coordinates, p_state, p_x, p_y, p_gui, p_nb_electron);
+	  return p_arena.create<cell<3>>(p_name, p_index, p_id, p_state, p_display, p_nb_electron, p_hash);
 	  break;
 	case 4:
-	  return new cell<4>(p_name, p_neighbour_coordinates, p_state, p_x, p_y, p_gui, p_nb_electron);
+	  return p_arena.create<cell<4>>(p_name, p_index, p_id, p_state, p_display, p_nb_electron, p_hash);
 	  break;
 	case 5:
-	  return new cell<5>(p_name, p_neighbour_coordinates, p_state, p_x, p_y, p_gui, p_nb_electron);
+	  return p_arena.create<cell<5>>(p_name, p_index, p_id, p_state, p_display, p_nb_electron, p_hash);
 	  break;
 	case 6:
-	  return new cell<6>(p_name, p_neighbour_coordinates, p_state, p_x, p_y, p_gui, p_nb_electron);
+	  return p_arena.create<cell<6>>(p_name, p_index, p_id, p_state, p_display, p_nb_electron, p_hash);
 	  break;
 	case 7:
-	  return new cell<7>(p_name, p_neighbour_coordinates, p_state, p_x, p_y, p_gui, p_nb_electron);
+	  return p_arena.create<cell<7>>(p_name, p_index, p_id, p_state, p_display, p_nb_electron, p_hash);
 	  break;
 	case 8:
-	  return new cell<8>(p_name, p_neighbour_coordinates, p_state, p_x, p_y, p_gui, p_nb_electron);
+	  return p_arena.create<cell<8>>(p_name, p_index, p_id, p_state, p_display, p_nb_electron, p_hash);
 	  break;
 	default:
 	  {
 	    std::stringstream l_stream;
-	    l_stream << p_neighbour_coordinates.size();
+	    l_stream << p_index.get_nb_neighbours(p_id);
 	    std::stringstream l_x_stream;
-	    l_x_stream << p_x;
+	    l_x_stream << p_index.get_coordinates(p_id).first;
 	    std::stringstream l_y_stream;
-	    l_y_stream << p_y;
+	    l_y_stream << p_index.get_coordinates(p_id).second;
 	    throw quicky_exception::quicky_logic_exception("Unsupported number of neighbour "+l_stream.str()+" for cell located in ("+l_x_stream.str()+","+l_y_stream.str()+")",__LINE__,__FILE__);
 	  }
 	}
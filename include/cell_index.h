@@ -0,0 +1,621 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef CELL_INDEX_H
+#define CELL_INDEX_H
+
+#include "wireworld_types.h"
+#include "quicky_exception.h"
+#include "work_stealing_pool.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <atomic>
+#include <sys/mman.h>
+#include <utility>
+#include <sstream>
+#include <cassert>
+
+namespace wireworld_systemc
+{
+  // Dense index of active cells. Cells are identified by integers given in
+  // row major, Morton or Hilbert order of their coordinates and neighbour
+  // lists are stored in compressed sparse row form: neighbours of cell i are
+  // m_neighbours[m_offsets[i]] to m_neighbours[m_offsets[i + 1] - 1].
+  // Arrays are either owned by index or located in a mapped file. Index can
+  // also carry partition of cells used by partition engine
+  class cell_index
+  {
+  public:
+    typedef uint32_t t_cell_id;
+    // Order of ids. Morton and Hilbert curves keep cells that are close on
+    // board close in memory, Hilbert curve having no long jumps
+    typedef enum class order {ROW_MAJOR=0, MORTON, HILBERT} t_order;
+
+    // Sort and neighbour resolution are shared between p_nb_threads threads
+    inline cell_index(const wireworld_common::wireworld_types::t_cell_list & p_cells,
+                      const wireworld_common::wireworld_types::t_neighbours & p_neighbours,
+                      const unsigned int & p_nb_threads,
+                      const t_order & p_order);
+    // Same cells and neighbours as p_index with ids given in p_order.
+    // Partitions are not kept
+    inline cell_index(const cell_index & p_index,
+                      const t_order & p_order);
+    // Build index from arrays already in compressed sparse row form, cells
+    // being sorted in row major order
+    inline cell_index(std::vector<wireworld_common::wireworld_types::t_coordinates> && p_coordinates,
+                      std::vector<uint32_t> && p_offsets,
+                      std::vector<t_cell_id> && p_neighbours);
+    // Use arrays located in mapped memory as is. Mapping is released by
+    // index, including when arrays are inconsistent. p_nb_neighbours is the
+    // size of p_neighbours array in mapping
+    inline cell_index(void * p_mapping,
+                      const size_t & p_mapping_size,
+                      const wireworld_common::wireworld_types::t_coordinates * p_coordinates,
+                      const t_cell_id & p_nb_cells,
+                      const uint32_t * p_offsets,
+                      const t_cell_id * p_neighbours,
+                      const uint32_t & p_nb_neighbours,
+                      const uint32_t & p_partition_size,
+                      const uint32_t * p_partitions,
+                      const t_order & p_order);
+    inline ~cell_index(void);
+    cell_index(const cell_index &) = delete;
+    cell_index & operator=(const cell_index &) = delete;
+
+    inline t_cell_id get_nb_cells(void)const;
+    inline const t_order & get_order(void)const;
+    inline const wireworld_common::wireworld_types::t_coordinates & get_coordinates(const t_cell_id & p_id)const;
+    inline bool find(const wireworld_common::wireworld_types::t_coordinates & p_coordinates,
+                     t_cell_id & p_id)const;
+    inline t_cell_id get_id(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const;
+
+    inline unsigned int get_nb_neighbours(const t_cell_id & p_id)const;
+    inline const t_cell_id * get_neighbours(const t_cell_id & p_id)const;
+
+    // Partition of cells in square tiles of p_partition_size side, partition
+    // ids being indexed by cell id
+    inline void set_partitions(const uint32_t & p_partition_size,
+                               std::vector<uint32_t> && p_partitions);
+    // Null when index carries no partition
+    inline const uint32_t & get_partition_size(void)const;
+    inline const uint32_t * get_partitions(void)const;
+
+    // Give back to system pages of file mapping read so far, they are read
+    // again from file when needed. Nothing is done when index is not mapped
+    inline void release_pages(void)const;
+    // Array elements read between two releases of mapping pages
+    static const uint32_t m_release_interval = 1 << 20;
+
+    // State of each cell at startup, electrons take precedence over tails
+    inline void get_states(const wireworld_common::wireworld_types::t_cell_list & p_tail_cells,
+                           const wireworld_common::wireworld_types::t_cell_list & p_electron_cells,
+                           std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)const;
+
+    inline static t_order string2order(const std::string & p_name);
+    inline static std::string order2string(const t_order & p_order);
+  private:
+    // Sort keys of cells with index of cell they come from, chunks being
+    // sorted by pool workers then merged pairwise
+    typedef std::vector<std::pair<uint64_t,t_cell_id>> t_keys;
+    inline static void sort(t_keys & p_keys,
+                            work_stealing_pool & p_pool,
+                            const unsigned int & p_nb_chunks);
+    inline void set_views(void);
+    inline bool is_consistent(void)const;
+    // Limits of p_nb_chunks ranges of similar size covering p_size elements
+    inline static std::vector<size_t> get_bounds(const size_t & p_size,
+                                                 const unsigned int & p_nb_chunks);
+    // Position of cell along curve of p_order
+    inline static uint64_t get_key(const t_order & p_order,
+                                   const wireworld_common::wireworld_types::t_coordinates & p_coordinates);
+    // Put bits of p_value in even bits
+    inline static uint64_t spread(uint64_t p_value);
+
+    // Arrays owned by index, empty when index uses a mapped file
+    std::vector<wireworld_common::wireworld_types::t_coordinates> m_coordinate_storage;
+    std::vector<uint32_t> m_offset_storage;
+    std::vector<t_cell_id> m_neighbour_storage;
+    std::vector<uint32_t> m_partition_storage;
+
+    const wireworld_common::wireworld_types::t_coordinates * m_coordinates;
+    t_cell_id m_nb_cells;
+    const uint32_t * m_offsets;
+    const t_cell_id * m_neighbours;
+    uint32_t m_partition_size;
+    const uint32_t * m_partitions;
+    t_order m_order;
+
+    void * m_mapping;
+    size_t m_mapping_size;
+
+    // Below this size threads cost more than they save
+    static const size_t m_min_parallel_cells = 65536;
+  };
+
+  //----------------------------------------------------------------------------
+  cell_index::cell_index(const wireworld_common::wireworld_types::t_cell_list & p_cells,
+                         const wireworld_common::wireworld_types::t_neighbours & p_neighbours,
+                         const unsigned int & p_nb_threads,
+                         const t_order & p_order):
+    m_coordinates(nullptr),
+    m_nb_cells(0),
+    m_offsets(nullptr),
+    m_neighbours(nullptr),
+    m_partition_size(0),
+    m_partitions(nullptr),
+    m_order(p_order),
+    m_mapping(nullptr),
+    m_mapping_size(0)
+    {
+      work_stealing_pool l_pool(p_cells.size() < m_min_parallel_cells ? 1 : p_nb_threads);
+      // Several chunks per worker let work stealing balance uneven chunks
+      unsigned int l_nb_chunks = 1 == l_pool.get_nb_workers() ? 1 : 4 * l_pool.get_nb_workers();
+
+      // Cells are sorted on their position along curve of requested order
+      t_keys l_keys(p_cells.size());
+      std::vector<size_t> l_bounds = get_bounds(p_cells.size(),l_nb_chunks);
+      l_pool.run([&](const unsigned int & p_worker, const unsigned int & p_task)
+                 {
+                   for(size_t l_index = l_bounds[p_task] ; l_index < l_bounds[p_task + 1] ; ++l_index)
+                     {
+                       l_keys[l_index] = t_keys::value_type(get_key(m_order,p_cells[l_index]),l_index);
+                     }
+                 },
+                 l_nb_chunks);
+      sort(l_keys,l_pool,l_nb_chunks);
+      m_coordinate_storage.reserve(l_keys.size());
+      for(t_cell_id l_index = 0 ; l_index < l_keys.size() ; ++l_index)
+        {
+          // Duplicated cells have the same key
+          if(!l_index || l_keys[l_index - 1].first != l_keys[l_index].first)
+            {
+              m_coordinate_storage.push_back(p_cells[l_keys[l_index].second]);
+            }
+        }
+      l_keys.clear();
+      l_keys.shrink_to_fit();
+      set_views();
+
+      // Count neighbours of each cell, offsets are the prefix sum of counts
+      l_bounds = get_bounds(m_coordinate_storage.size(),l_nb_chunks);
+      std::vector<const wireworld_common::wireworld_types::t_cell_list *> l_neighbour_lists(m_coordinate_storage.size(),nullptr);
+      m_offset_storage.assign(m_coordinate_storage.size() + 1,0);
+      l_pool.run([&](const unsigned int & p_worker, const unsigned int & p_task)
+                 {
+                   for(size_t l_id = l_bounds[p_task] ; l_id < l_bounds[p_task + 1] ; ++l_id)
+                     {
+                       wireworld_common::wireworld_types::t_neighbours::const_iterator l_neighbour_list_iter = p_neighbours.find(m_coordinates[l_id]);
+                       assert(p_neighbours.end() != l_neighbour_list_iter);
+                       l_neighbour_lists[l_id] = &(l_neighbour_list_iter->second);
+                       m_offset_storage[l_id + 1] = l_neighbour_list_iter->second.size();
+                     }
+                 },
+                 l_nb_chunks);
+      std::partial_sum(m_offset_storage.begin(),m_offset_storage.end(),m_offset_storage.begin());
+
+      // Resolve neighbour coordinates into ids. Exceptions cannot cross
+      // threads so unknown neighbours are only reported afterwards
+      m_neighbour_storage.resize(m_offset_storage.back());
+      set_views();
+      std::atomic<bool> l_unknown(false);
+      l_pool.run([&](const unsigned int & p_worker, const unsigned int & p_task)
+                 {
+                   for(size_t l_id = l_bounds[p_task] ; l_id < l_bounds[p_task + 1] ; ++l_id)
+                     {
+                       t_cell_id * l_neighbours = m_neighbour_storage.data() + m_offset_storage[l_id];
+                       for(auto l_neighbour_iter: *l_neighbour_lists[l_id])
+                         {
+                           if(!find(l_neighbour_iter,*l_neighbours++))
+                             {
+                               l_unknown = true;
+                             }
+                         }
+                     }
+                 },
+                 l_nb_chunks);
+      if(l_unknown)
+        {
+          for(auto l_neighbour_list: l_neighbour_lists)
+            {
+              for(auto l_neighbour_iter: *l_neighbour_list)
+                {
+                  get_id(l_neighbour_iter);
+                }
+            }
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  cell_index::cell_index(const cell_index & p_index,
+                         const t_order & p_order):
+    m_coordinates(nullptr),
+    m_nb_cells(0),
+    m_offsets(nullptr),
+    m_neighbours(nullptr),
+    m_partition_size(0),
+    m_partitions(nullptr),
+    m_order(p_order),
+    m_mapping(nullptr),
+    m_mapping_size(0)
+    {
+      work_stealing_pool l_pool(1);
+      t_keys l_keys(p_index.get_nb_cells());
+      for(t_cell_id l_id = 0 ; l_id < p_index.get_nb_cells() ; ++l_id)
+        {
+          l_keys[l_id] = t_keys::value_type(get_key(m_order,p_index.get_coordinates(l_id)),l_id);
+        }
+      sort(l_keys,l_pool,1);
+
+      // New id of each cell of p_index
+      std::vector<t_cell_id> l_ids(l_keys.size());
+      m_coordinate_storage.reserve(l_keys.size());
+      m_offset_storage.reserve(l_keys.size() + 1);
+      m_offset_storage.push_back(0);
+      for(t_cell_id l_id = 0 ; l_id < l_keys.size() ; ++l_id)
+        {
+          l_ids[l_keys[l_id].second] = l_id;
+          m_coordinate_storage.push_back(p_index.get_coordinates(l_keys[l_id].second));
+          m_offset_storage.push_back(m_offset_storage.back() + p_index.get_nb_neighbours(l_keys[l_id].second));
+        }
+      m_neighbour_storage.reserve(m_offset_storage.back());
+      for(t_cell_id l_id = 0 ; l_id < l_keys.size() ; ++l_id)
+        {
+          const t_cell_id * l_neighbours = p_index.get_neighbours(l_keys[l_id].second);
+          for(unsigned int l_index = 0 ; l_index < p_index.get_nb_neighbours(l_keys[l_id].second) ; ++l_index)
+            {
+              m_neighbour_storage.push_back(l_ids[l_neighbours[l_index]]);
+            }
+        }
+      set_views();
+    }
+
+  //----------------------------------------------------------------------------
+  cell_index::cell_index(std::vector<wireworld_common::wireworld_types::t_coordinates> && p_coordinates,
+                         std::vector<uint32_t> && p_offsets,
+                         std::vector<t_cell_id> && p_neighbours):
+    m_coordinate_storage(std::move(p_coordinates)),
+    m_offset_storage(std::move(p_offsets)),
+    m_neighbour_storage(std::move(p_neighbours)),
+    m_coordinates(nullptr),
+    m_nb_cells(0),
+    m_offsets(nullptr),
+    m_neighbours(nullptr),
+    m_partition_size(0),
+    m_partitions(nullptr),
+    m_order(t_order::ROW_MAJOR),
+    m_mapping(nullptr),
+    m_mapping_size(0)
+    {
+      if(m_offset_storage.size() != m_coordinate_storage.size() + 1 || m_offset_storage.back() != m_neighbour_storage.size())
+        {
+          throw quicky_exception::quicky_logic_exception("Inconsistent cell index arrays",__LINE__,__FILE__);
+        }
+      set_views();
+      if(!is_consistent())
+        {
+          throw quicky_exception::quicky_logic_exception("Inconsistent cell index arrays",__LINE__,__FILE__);
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  cell_index::cell_index(void * p_mapping,
+                         const size_t & p_mapping_size,
+                         const wireworld_common::wireworld_types::t_coordinates * p_coordinates,
+                         const t_cell_id & p_nb_cells,
+                         const uint32_t * p_offsets,
+                         const t_cell_id * p_neighbours,
+                         const uint32_t & p_nb_neighbours,
+                         const uint32_t & p_partition_size,
+                         const uint32_t * p_partitions,
+                         const t_order & p_order):
+    m_coordinates(p_coordinates),
+    m_nb_cells(p_nb_cells),
+    m_offsets(p_offsets),
+    m_neighbours(p_neighbours),
+    m_partition_size(p_partitions ? p_partition_size : 0),
+    m_partitions(p_partitions),
+    m_order(p_order),
+    m_mapping(p_mapping),
+    m_mapping_size(p_mapping_size)
+    {
+      // Last offset bounds neighbour reads of is_consistent
+      if(m_offsets[m_nb_cells] != p_nb_neighbours || !is_consistent())
+        {
+          munmap(m_mapping,m_mapping_size);
+          throw quicky_exception::quicky_logic_exception("Inconsistent cell index arrays",__LINE__,__FILE__);
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  cell_index::~cell_index(void)
+    {
+      if(m_mapping)
+        {
+          munmap(m_mapping,m_mapping_size);
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  void cell_index::set_views(void)
+  {
+    m_coordinates = m_coordinate_storage.data();
+    m_nb_cells = m_coordinate_storage.size();
+    m_offsets = m_offset_storage.data();
+    m_neighbours = m_neighbour_storage.data();
+  }
+
+  //----------------------------------------------------------------------------
+  bool cell_index::is_consistent(void)const
+  {
+    // Mapped arrays are read once here, their pages are given back on the
+    // way so that resident memory does not depend on number of cells
+    bool l_ok = !m_offsets[0];
+    for(t_cell_id l_id = 0 ; l_ok && l_id < m_nb_cells ; ++l_id)
+      {
+        l_ok = m_offsets[l_id] <= m_offsets[l_id + 1] && (!l_id || get_key(m_order,m_coordinates[l_id - 1]) < get_key(m_order,m_coordinates[l_id]));
+        if(!((l_id + 1) % m_release_interval)) release_pages();
+      }
+    for(uint32_t l_index = 0 ; l_ok && l_index < m_offsets[m_nb_cells] ; ++l_index)
+      {
+        l_ok = m_neighbours[l_index] < m_nb_cells;
+        if(!((l_index + 1) % m_release_interval)) release_pages();
+      }
+    // There cannot be more partitions than cells
+    for(t_cell_id l_id = 0 ; l_ok && m_partitions && l_id < m_nb_cells ; ++l_id)
+      {
+        l_ok = m_partitions[l_id] < m_nb_cells;
+        if(!((l_id + 1) % m_release_interval)) release_pages();
+      }
+    release_pages();
+    return l_ok;
+  }
+
+  //----------------------------------------------------------------------------
+  cell_index::t_cell_id cell_index::get_nb_cells(void)const
+  {
+    return m_nb_cells;
+  }
+
+  //----------------------------------------------------------------------------
+  const cell_index::t_order & cell_index::get_order(void)const
+    {
+      return m_order;
+    }
+
+  //----------------------------------------------------------------------------
+  const wireworld_common::wireworld_types::t_coordinates & cell_index::get_coordinates(const t_cell_id & p_id)const
+    {
+      assert(p_id < m_nb_cells);
+      return m_coordinates[p_id];
+    }
+
+  //----------------------------------------------------------------------------
+  bool cell_index::find(const wireworld_common::wireworld_types::t_coordinates & p_coordinates,
+                        t_cell_id & p_id)const
+  {
+    const t_order & l_order = m_order;
+    const wireworld_common::wireworld_types::t_coordinates * l_iter = std::lower_bound(m_coordinates,
+                                                                                      m_coordinates + m_nb_cells,
+                                                                                      get_key(m_order,p_coordinates),
+                                                                                      [&](const wireworld_common::wireworld_types::t_coordinates & p_cell, const uint64_t & p_key)
+                                                                                      {
+                                                                                        return get_key(l_order,p_cell) < p_key;
+                                                                                      });
+    if(m_coordinates + m_nb_cells == l_iter || *l_iter != p_coordinates)
+      {
+        return false;
+      }
+    p_id = l_iter - m_coordinates;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  cell_index::t_cell_id cell_index::get_id(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const
+  {
+    t_cell_id l_id = 0;
+    if(!find(p_coordinates,l_id))
+      {
+        std::stringstream l_stream;
+        l_stream << "(" << p_coordinates.first << "," << p_coordinates.second << ")";
+        throw quicky_exception::quicky_logic_exception("Cell " + l_stream.str() + " is not an active cell",__LINE__,__FILE__);
+      }
+    return l_id;
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int cell_index::get_nb_neighbours(const t_cell_id & p_id)const
+  {
+    assert(p_id < m_nb_cells);
+    return m_offsets[p_id + 1] - m_offsets[p_id];
+  }
+
+  //----------------------------------------------------------------------------
+  const cell_index::t_cell_id * cell_index::get_neighbours(const t_cell_id & p_id)const
+  {
+    assert(p_id < m_nb_cells);
+    return m_neighbours + m_offsets[p_id];
+  }
+
+  //----------------------------------------------------------------------------
+  void cell_index::set_partitions(const uint32_t & p_partition_size,
+                                  std::vector<uint32_t> && p_partitions)
+  {
+    assert(p_partitions.size() == m_nb_cells);
+    m_partition_storage = std::move(p_partitions);
+    m_partition_size = p_partition_size;
+    m_partitions = m_partition_storage.data();
+  }
+
+  //----------------------------------------------------------------------------
+  const uint32_t & cell_index::get_partition_size(void)const
+    {
+      return m_partition_size;
+    }
+
+  //----------------------------------------------------------------------------
+  const uint32_t * cell_index::get_partitions(void)const
+  {
+    return m_partitions;
+  }
+
+  //----------------------------------------------------------------------------
+  void cell_index::release_pages(void)const
+  {
+    if(m_mapping)
+      {
+        madvise(m_mapping,m_mapping_size,MADV_DONTNEED);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void cell_index::get_states(const wireworld_common::wireworld_types::t_cell_list & p_tail_cells,
+                              const wireworld_common::wireworld_types::t_cell_list & p_electron_cells,
+                              std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)const
+  {
+    p_states.assign(m_nb_cells,wireworld_common::wireworld_types::t_cell_state::COPPER);
+    for(auto l_iter: p_tail_cells)
+      {
+        p_states[get_id(l_iter)] = wireworld_common::wireworld_types::t_cell_state::TAIL;
+      }
+    for(auto l_iter: p_electron_cells)
+      {
+        p_states[get_id(l_iter)] = wireworld_common::wireworld_types::t_cell_state::ELECTRON;
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  std::vector<size_t> cell_index::get_bounds(const size_t & p_size,
+                                             const unsigned int & p_nb_chunks)
+  {
+    std::vector<size_t> l_bounds(p_nb_chunks + 1);
+    for(unsigned int l_chunk = 0 ; l_chunk <= p_nb_chunks ; ++l_chunk)
+      {
+        l_bounds[l_chunk] = (p_size * l_chunk) / p_nb_chunks;
+      }
+    return l_bounds;
+  }
+
+  //----------------------------------------------------------------------------
+  cell_index::t_order cell_index::string2order(const std::string & p_name)
+  {
+    if("row_major" == p_name)
+      {
+        return t_order::ROW_MAJOR;
+      }
+    else if("morton" == p_name)
+      {
+        return t_order::MORTON;
+      }
+    else if("hilbert" == p_name)
+      {
+        return t_order::HILBERT;
+      }
+    throw quicky_exception::quicky_runtime_exception("Unknown cell order \"" + p_name + "\", expecting row_major, morton or hilbert",__LINE__,__FILE__);
+  }
+
+  //----------------------------------------------------------------------------
+  std::string cell_index::order2string(const t_order & p_order)
+  {
+    switch(p_order)
+      {
+      case t_order::ROW_MAJOR:
+        return "row_major";
+      case t_order::MORTON:
+        return "morton";
+      case t_order::HILBERT:
+        return "hilbert";
+      }
+    return "";
+  }
+
+  //----------------------------------------------------------------------------
+  void cell_index::sort(t_keys & p_keys,
+                        work_stealing_pool & p_pool,
+                        const unsigned int & p_nb_chunks)
+  {
+    // Chunks are sorted independently then merged pairwise
+    std::vector<size_t> l_bounds = get_bounds(p_keys.size(),p_nb_chunks);
+    p_pool.run([&](const unsigned int & p_worker, const unsigned int & p_task)
+               {
+                 std::sort(p_keys.begin() + l_bounds[p_task],p_keys.begin() + l_bounds[p_task + 1]);
+               },
+               p_nb_chunks);
+    for(unsigned int l_width = 1 ; l_width < p_nb_chunks ; l_width *= 2)
+      {
+        p_pool.run([&](const unsigned int & p_worker, const unsigned int & p_task)
+                   {
+                     unsigned int l_first = 2 * l_width * p_task;
+                     unsigned int l_middle = std::min(l_first + l_width,p_nb_chunks);
+                     unsigned int l_last = std::min(l_first + 2 * l_width,p_nb_chunks);
+                     std::inplace_merge(p_keys.begin() + l_bounds[l_first],p_keys.begin() + l_bounds[l_middle],p_keys.begin() + l_bounds[l_last]);
+                   },
+                   (p_nb_chunks + 2 * l_width - 1) / (2 * l_width));
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  uint64_t cell_index::get_key(const t_order & p_order,
+                               const wireworld_common::wireworld_types::t_coordinates & p_coordinates)
+  {
+    uint64_t l_x = p_coordinates.first;
+    uint64_t l_y = p_coordinates.second;
+    switch(p_order)
+      {
+      case t_order::ROW_MAJOR:
+        return (l_y << 32) | l_x;
+      case t_order::MORTON:
+        return spread(l_x) | (spread(l_y) << 1);
+      case t_order::HILBERT:
+        break;
+      }
+    // Walk down quadrants of whole 2^32 x 2^32 board, each level adding
+    // position of quadrant along curve then rotating coordinates so that
+    // sub-curve starts where previous one ended
+    uint64_t l_key = 0;
+    for(uint64_t l_side = UINT64_C(1) << 31 ; l_side ; l_side >>= 1)
+      {
+        uint64_t l_rx = (l_x & l_side) ? 1 : 0;
+        uint64_t l_ry = (l_y & l_side) ? 1 : 0;
+        l_key += l_side * l_side * ((3 * l_rx) ^ l_ry);
+        if(!l_ry)
+          {
+            if(l_rx)
+              {
+                l_x = UINT32_MAX - l_x;
+                l_y = UINT32_MAX - l_y;
+              }
+            std::swap(l_x,l_y);
+          }
+      }
+    return l_key;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64_t cell_index::spread(uint64_t p_value)
+  {
+    p_value = (p_value | (p_value << 16)) & UINT64_C(0x0000FFFF0000FFFF);
+    p_value = (p_value | (p_value << 8)) & UINT64_C(0x00FF00FF00FF00FF);
+    p_value = (p_value | (p_value << 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+    p_value = (p_value | (p_value << 2)) & UINT64_C(0x3333333333333333);
+    p_value = (p_value | (p_value << 1)) & UINT64_C(0x5555555555555555);
+    return p_value;
+  }
+}
+#endif // CELL_INDEX_H
+//EOF
@@ -0,0 +1,64 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef CELL_TRANSITION_H
+#define CELL_TRANSITION_H
+
+#include "wireworld_types.h"
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // State transition table of a cell having SIZE neighbours computed at
+  // compile time. Entry for a state and a number of electrons among
+  // neighbours is stored on 2 bits of a single word so that next state is
+  // obtained with a shift and a mask instead of a switch
+  template <unsigned int SIZE>
+    class cell_transition
+  {
+  public:
+    inline static wireworld_common::wireworld_types::t_cell_state get_next(const wireworld_common::wireworld_types::t_cell_state & p_state,
+                                                                            const unsigned int & p_nb_electron);
+  private:
+    static constexpr uint64_t get_entry(const unsigned int p_state,
+                                        const unsigned int p_nb_electron)
+    {
+      return (unsigned int)wireworld_common::wireworld_types::t_cell_state::COPPER == p_state ? (p_nb_electron && p_nb_electron < 3 ? (uint64_t)wireworld_common::wireworld_types::t_cell_state::ELECTRON : (uint64_t)wireworld_common::wireworld_types::t_cell_state::COPPER) :
+        ((unsigned int)wireworld_common::wireworld_types::t_cell_state::ELECTRON == p_state ? (uint64_t)wireworld_common::wireworld_types::t_cell_state::TAIL : (uint64_t)wireworld_common::wireworld_types::t_cell_state::COPPER);
+    }
+
+    static constexpr uint64_t build(const unsigned int p_index)
+    {
+      return 3 * (SIZE + 1) == p_index ? 0 : (get_entry(p_index / (SIZE + 1),p_index % (SIZE + 1)) << (2 * p_index)) | build(p_index + 1);
+    }
+
+    static_assert(3 * (SIZE + 1) * 2 <= 64,"Transition table does not fit in a word");
+    static_assert((unsigned int)wireworld_common::wireworld_types::t_cell_state::COPPER < 3 && (unsigned int)wireworld_common::wireworld_types::t_cell_state::TAIL < 3 && (unsigned int)wireworld_common::wireworld_types::t_cell_state::ELECTRON < 3,"Cell states are expected to be coded on 2 bits");
+  };
+
+  //----------------------------------------------------------------------------
+  template <unsigned int SIZE>
+    wireworld_common::wireworld_types::t_cell_state cell_transition<SIZE>::get_next(const wireworld_common::wireworld_types::t_cell_state & p_state,
+                                                                                     const unsigned int & p_nb_electron)
+    {
+      constexpr uint64_t l_table = build(0);
+      return (wireworld_common::wireworld_types::t_cell_state)((l_table >> (2 * ((unsigned int)p_state * (SIZE + 1) + p_nb_electron))) & 0x3);
+    }
+}
+#endif // CELL_TRANSITION_H
+//EOF
@@ -0,0 +1,407 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "cell_index.h"
+#include "wireworld_types.h"
+#include "wireworld_configuration.h"
+#include "quicky_exception.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace wireworld_systemc
+{
+  // Binary snapshot of a simulation: configuration, cell index and state of
+  // every cell at a given generation. File is a fixed size header followed
+  // by arrays so that it can be mapped in memory as is:
+  //  - coordinates of cells   : 2 x nb_cells uint32_t
+  //  - neighbour offsets      : nb_cells + 1 uint32_t
+  //  - neighbour ids          : nb_neighbours uint32_t
+  //  - inactive cells         : 2 x nb_inactive uint32_t
+  //  - partition ids          : nb_cells uint32_t, only if partition size is
+  //                             not null
+  //  - cell states            : nb_cells uint8_t
+  // A snapshot of generation 0 written by --compile is a precompiled netlist.
+  // Restored cell index uses arrays of mapped file without copying them.
+  // Version 1 files have no partition size in header and no partition ids.
+  // Cells are stored in order of cell index, row major in files written
+  // before cell order was stored in header
+  class checkpoint
+  {
+  public:
+    inline checkpoint(const std::string & p_file_name,
+                      const uint64_t & p_interval,
+                      const uint64_t & p_first_generation,
+                      const cell_index & p_index,
+                      const wireworld_common::wireworld_configuration & p_conf,
+                      const uint32_t & p_x_max,
+                      const uint32_t & p_y_max,
+                      const wireworld_common::wireworld_types::t_cell_list & p_inactive_cells);
+
+    inline bool is_enabled(void)const;
+    // Tell if a snapshot should be taken at this generation
+    inline bool is_due(const uint64_t & p_generation,
+                       const bool & p_stop)const;
+    // First generation after p_generation at which a periodic snapshot is
+    // due, UINT64_MAX if none
+    inline uint64_t get_next_generation(const uint64_t & p_generation)const;
+    // Write states of generation p_generation, states being indexed by id
+    inline void save(const uint64_t & p_generation,
+                     const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)const;
+
+    // Read snapshot. Returned index is owned by caller. When p_mapped_states
+    // is not null states are checked but not converted: p_states stays
+    // empty and *p_mapped_states points to one byte per cell in mapping
+    // owned by index
+    inline static cell_index * load(const std::string & p_file_name,
+                                    uint64_t & p_generation,
+                                    std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                    wireworld_common::wireworld_configuration & p_conf,
+                                    uint32_t & p_x_max,
+                                    uint32_t & p_y_max,
+                                    wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
+                                    const uint8_t ** p_mapped_states = nullptr);
+  private:
+    static const uint32_t m_version = 2;
+
+    class header
+    {
+    public:
+      char m_magic[8];
+      uint32_t m_version;
+      uint32_t m_nb_cells;
+      uint32_t m_nb_neighbours;
+      uint32_t m_nb_inactive;
+      uint64_t m_generation;
+      uint32_t m_nb_electron;
+      uint32_t m_nb_tail;
+      uint32_t m_x_max;
+      uint32_t m_y_max;
+      uint64_t m_nb_max_cycle;
+      uint32_t m_start_cycle;
+      uint32_t m_refresh_interval;
+      uint32_t m_display_duration;
+      uint32_t m_trace;
+      uint32_t m_trace_x_origin;
+      uint32_t m_trace_y_origin;
+      uint32_t m_trace_width;
+      uint32_t m_trace_height;
+      // Fields added by version 2
+      uint32_t m_partition_size;
+      uint32_t m_cell_order;
+    };
+
+    inline static size_t get_header_size(const uint32_t & p_version);
+    inline static size_t get_file_size(const header & p_header);
+    inline static const char * get_magic(void);
+
+    const std::string m_file_name;
+    const uint64_t m_interval;
+    // Generation simulation starts from, nothing to save there
+    const uint64_t m_first_generation;
+    const cell_index & m_index;
+    const wireworld_common::wireworld_configuration & m_config;
+    const uint32_t m_x_max;
+    const uint32_t m_y_max;
+    const wireworld_common::wireworld_types::t_cell_list & m_inactive_cells;
+  };
+
+  //----------------------------------------------------------------------------
+  checkpoint::checkpoint(const std::string & p_file_name,
+                         const uint64_t & p_interval,
+                         const uint64_t & p_first_generation,
+                         const cell_index & p_index,
+                         const wireworld_common::wireworld_configuration & p_conf,
+                         const uint32_t & p_x_max,
+                         const uint32_t & p_y_max,
+                         const wireworld_common::wireworld_types::t_cell_list & p_inactive_cells):
+    m_file_name(p_file_name),
+    m_interval(p_interval),
+    m_first_generation(p_first_generation),
+    m_index(p_index),
+    m_config(p_conf),
+    m_x_max(p_x_max),
+    m_y_max(p_y_max),
+    m_inactive_cells(p_inactive_cells)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  bool checkpoint::is_enabled(void)const
+  {
+    return !m_file_name.empty();
+  }
+
+  //----------------------------------------------------------------------------
+  bool checkpoint::is_due(const uint64_t & p_generation,
+                          const bool & p_stop)const
+  {
+    return is_enabled() && (p_stop || (m_interval && p_generation != m_first_generation && !(p_generation % m_interval)));
+  }
+
+  //----------------------------------------------------------------------------
+  uint64_t checkpoint::get_next_generation(const uint64_t & p_generation)const
+  {
+    if(!is_enabled() || !m_interval)
+      {
+        return UINT64_MAX;
+      }
+    return (p_generation / m_interval + 1) * m_interval;
+  }
+
+  //----------------------------------------------------------------------------
+  void checkpoint::save(const uint64_t & p_generation,
+                        const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)const
+  {
+    assert(p_states.size() == m_index.get_nb_cells());
+    header l_header;
+    memset(&l_header,0,sizeof(l_header));
+    memcpy(l_header.m_magic,get_magic(),sizeof(l_header.m_magic));
+    l_header.m_version = m_version;
+    l_header.m_nb_cells = m_index.get_nb_cells();
+    l_header.m_nb_inactive = m_inactive_cells.size();
+    l_header.m_generation = p_generation;
+    l_header.m_x_max = m_x_max;
+    l_header.m_y_max = m_y_max;
+    l_header.m_nb_max_cycle = m_config.get_nb_max_cycle();
+    l_header.m_start_cycle = m_config.get_start_cycle();
+    l_header.m_refresh_interval = m_config.get_refresh_interval();
+    l_header.m_display_duration = m_config.get_display_duration();
+    l_header.m_trace = m_config.get_trace();
+    l_header.m_trace_x_origin = m_config.get_trace_x_origin();
+    l_header.m_trace_y_origin = m_config.get_trace_y_origin();
+    l_header.m_trace_width = m_config.get_trace_width();
+    l_header.m_trace_height = m_config.get_trace_height();
+    l_header.m_partition_size = m_index.get_partitions() ? m_index.get_partition_size() : 0;
+    l_header.m_cell_order = (uint32_t)m_index.get_order();
+
+    std::vector<uint32_t> l_coordinates;
+    std::vector<uint32_t> l_offsets;
+    std::vector<uint32_t> l_neighbours;
+    std::vector<uint8_t> l_states(p_states.size());
+    l_coordinates.reserve(2 * l_header.m_nb_cells);
+    l_offsets.reserve(l_header.m_nb_cells + 1);
+    for(cell_index::t_cell_id l_id = 0 ; l_id < m_index.get_nb_cells() ; ++l_id)
+      {
+        l_coordinates.push_back(m_index.get_coordinates(l_id).first);
+        l_coordinates.push_back(m_index.get_coordinates(l_id).second);
+        l_offsets.push_back(l_neighbours.size());
+        l_neighbours.insert(l_neighbours.end(),m_index.get_neighbours(l_id),m_index.get_neighbours(l_id) + m_index.get_nb_neighbours(l_id));
+        l_states[l_id] = (uint8_t)p_states[l_id];
+        l_header.m_nb_electron += wireworld_common::wireworld_types::t_cell_state::ELECTRON == p_states[l_id];
+        l_header.m_nb_tail += wireworld_common::wireworld_types::t_cell_state::TAIL == p_states[l_id];
+      }
+    l_offsets.push_back(l_neighbours.size());
+    l_header.m_nb_neighbours = l_neighbours.size();
+    std::vector<uint32_t> l_inactive;
+    l_inactive.reserve(2 * m_inactive_cells.size());
+    for(auto l_iter: m_inactive_cells)
+      {
+        l_inactive.push_back(l_iter.first);
+        l_inactive.push_back(l_iter.second);
+      }
+
+    // Write in a temporary file then rename it so that a crash while saving
+    // does not destroy previous snapshot
+    std::string l_tmp_name = m_file_name + ".tmp";
+    std::ofstream l_file(l_tmp_name.c_str(),std::ios::binary | std::ios::trunc);
+    if(!l_file.is_open())
+      {
+        throw quicky_exception::quicky_runtime_exception("Unable to create checkpoint file \"" + l_tmp_name + "\"",__LINE__,__FILE__);
+      }
+    l_file.write((const char*)&l_header,sizeof(l_header));
+    l_file.write((const char*)l_coordinates.data(),l_coordinates.size() * sizeof(uint32_t));
+    l_file.write((const char*)l_offsets.data(),l_offsets.size() * sizeof(uint32_t));
+    l_file.write((const char*)l_neighbours.data(),l_neighbours.size() * sizeof(uint32_t));
+    l_file.write((const char*)l_inactive.data(),l_inactive.size() * sizeof(uint32_t));
+    if(l_header.m_partition_size)
+      {
+        l_file.write((const char*)m_index.get_partitions(),l_header.m_nb_cells * sizeof(uint32_t));
+      }
+    l_file.write((const char*)l_states.data(),l_states.size());
+    l_file.close();
+    if(l_file.fail() || rename(l_tmp_name.c_str(),m_file_name.c_str()))
+      {
+        throw quicky_exception::quicky_runtime_exception("Unable to write checkpoint file \"" + m_file_name + "\"",__LINE__,__FILE__);
+      }
+    std::cout << "Checkpoint of generation " << p_generation << " written in \"" << m_file_name << "\"" << std::endl ;
+  }
+
+  //----------------------------------------------------------------------------
+  cell_index * checkpoint::load(const std::string & p_file_name,
+                                uint64_t & p_generation,
+                                std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                wireworld_common::wireworld_configuration & p_conf,
+                                uint32_t & p_x_max,
+                                uint32_t & p_y_max,
+                                wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
+                                const uint8_t ** p_mapped_states)
+  {
+    int l_fd = open(p_file_name.c_str(),O_RDONLY);
+    if(-1 == l_fd)
+      {
+        throw quicky_exception::quicky_runtime_exception("Unable to open checkpoint file \"" + p_file_name + "\"",__LINE__,__FILE__);
+      }
+    struct stat l_stat;
+    if(fstat(l_fd,&l_stat) || (size_t)l_stat.st_size < get_header_size(1))
+      {
+        close(l_fd);
+        throw quicky_exception::quicky_runtime_exception("Checkpoint file \"" + p_file_name + "\" is truncated",__LINE__,__FILE__);
+      }
+    size_t l_size = l_stat.st_size;
+    void * l_data = mmap(nullptr,l_size,PROT_READ,MAP_PRIVATE,l_fd,0);
+    close(l_fd);
+    if(MAP_FAILED == l_data)
+      {
+        throw quicky_exception::quicky_runtime_exception("Unable to map checkpoint file \"" + p_file_name + "\"",__LINE__,__FILE__);
+      }
+
+    // Fields missing in older versions stay null, which is row major order
+    // and no partition
+    header l_header;
+    memset(&l_header,0,sizeof(l_header));
+    memcpy(&l_header,l_data,get_header_size(1));
+    memcpy(&l_header,l_data,std::min(l_size,get_header_size(l_header.m_version)));
+    std::string l_error;
+    if(memcmp(l_header.m_magic,get_magic(),sizeof(l_header.m_magic)))
+      {
+        l_error = "is not a checkpoint file";
+      }
+    else if(!l_header.m_version || l_header.m_version > m_version)
+      {
+        l_error = "has an unsupported version";
+      }
+    else if(l_header.m_cell_order > (uint32_t)cell_index::t_order::HILBERT)
+      {
+        l_error = "has an unknown cell order";
+      }
+    else if(get_file_size(l_header) != l_size)
+      {
+        l_error = "is truncated";
+      }
+    if(!l_error.empty())
+      {
+        munmap(l_data,l_size);
+        throw quicky_exception::quicky_runtime_exception("Checkpoint file \"" + p_file_name + "\" " + l_error,__LINE__,__FILE__);
+      }
+
+    static_assert(sizeof(wireworld_common::wireworld_types::t_coordinates) == 2 * sizeof(uint32_t) && offsetof(wireworld_common::wireworld_types::t_coordinates,second) == sizeof(uint32_t),"Coordinates cannot be mapped from file");
+    const uint32_t * l_coordinates = (const uint32_t*)((const char*)l_data + get_header_size(l_header.m_version));
+    const uint32_t * l_offsets = l_coordinates + 2 * (size_t)l_header.m_nb_cells;
+    const uint32_t * l_neighbours = l_offsets + l_header.m_nb_cells + 1;
+    const uint32_t * l_inactive = l_neighbours + l_header.m_nb_neighbours;
+    const uint32_t * l_partitions = l_inactive + 2 * (size_t)l_header.m_nb_inactive;
+    const uint8_t * l_states = (const uint8_t*)(l_partitions + (l_header.m_partition_size ? l_header.m_nb_cells : 0));
+
+    // States are the only per cell array converted
+    p_states.clear();
+    if(!p_mapped_states)
+      {
+        p_states.resize(l_header.m_nb_cells);
+      }
+    for(uint32_t l_id = 0 ; l_id < l_header.m_nb_cells ; ++l_id)
+      {
+        if((uint8_t)wireworld_common::wireworld_types::t_cell_state::COPPER != l_states[l_id] &&
+           (uint8_t)wireworld_common::wireworld_types::t_cell_state::ELECTRON != l_states[l_id] &&
+           (uint8_t)wireworld_common::wireworld_types::t_cell_state::TAIL != l_states[l_id])
+          {
+            munmap(l_data,l_size);
+            throw quicky_exception::quicky_runtime_exception("Checkpoint file \"" + p_file_name + "\" has an invalid cell state",__LINE__,__FILE__);
+          }
+        if(!p_mapped_states)
+          {
+            p_states[l_id] = (wireworld_common::wireworld_types::t_cell_state)l_states[l_id];
+          }
+        // Clean pages of mapping are read again from file when needed
+        else if(!((l_id + 1) % cell_index::m_release_interval))
+          {
+            madvise(l_data,l_size,MADV_DONTNEED);
+          }
+      }
+    if(p_mapped_states)
+      {
+        *p_mapped_states = l_states;
+      }
+    p_inactive_cells.clear();
+    p_inactive_cells.reserve(l_header.m_nb_inactive);
+    for(uint32_t l_index = 0 ; l_index < l_header.m_nb_inactive ; ++l_index)
+      {
+        p_inactive_cells.push_back(wireworld_common::wireworld_types::t_coordinates(l_inactive[2 * l_index],l_inactive[2 * l_index + 1]));
+      }
+    p_generation = l_header.m_generation;
+    p_x_max = l_header.m_x_max;
+    p_y_max = l_header.m_y_max;
+    p_conf.set_nb_max_cycle(l_header.m_nb_max_cycle);
+    p_conf.set_start_cycle(l_header.m_start_cycle);
+    p_conf.set_refresh_interval(l_header.m_refresh_interval);
+    p_conf.set_display_duration(l_header.m_display_duration);
+    p_conf.set_trace(l_header.m_trace);
+    p_conf.set_trace_x_origin(l_header.m_trace_x_origin);
+    p_conf.set_trace_y_origin(l_header.m_trace_y_origin);
+    p_conf.set_trace_width(l_header.m_trace_width);
+    p_conf.set_trace_height(l_header.m_trace_height);
+
+    std::cout << "Restore generation " << p_generation << " from \"" << p_file_name << "\"" << std::endl ;
+    // Index owns mapping from here
+    return new cell_index(l_data,
+                          l_size,
+                          (const wireworld_common::wireworld_types::t_coordinates*)l_coordinates,
+                          l_header.m_nb_cells,
+                          l_offsets,
+                          l_neighbours,
+                          l_header.m_nb_neighbours,
+                          l_header.m_partition_size,
+                          l_header.m_partition_size ? l_partitions : nullptr,
+                          (cell_index::t_order)l_header.m_cell_order);
+  }
+
+  //----------------------------------------------------------------------------
+  size_t checkpoint::get_header_size(const uint32_t & p_version)
+  {
+    return 1 == p_version ? offsetof(header,m_partition_size) : sizeof(header);
+  }
+
+  //----------------------------------------------------------------------------
+  size_t checkpoint::get_file_size(const header & p_header)
+  {
+    return get_header_size(p_header.m_version) +
+      sizeof(uint32_t) * (2 * (size_t)p_header.m_nb_cells + p_header.m_nb_cells + 1 + p_header.m_nb_neighbours + 2 * (size_t)p_header.m_nb_inactive + (p_header.m_partition_size ? (size_t)p_header.m_nb_cells : 0)) +
+      p_header.m_nb_cells;
+  }
+
+  //----------------------------------------------------------------------------
+  const char * checkpoint::get_magic(void)
+  {
+    return "WWCKPT\0";
+  }
+}
+#endif // CHECKPOINT_H
+//EOF
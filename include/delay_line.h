@@ -0,0 +1,355 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef DELAY_LINE_H
+#define DELAY_LINE_H
+
+#include "systemc.h"
+#include "wireworld_types.h"
+#include "quicky_exception.h"
+#include "display_if.h"
+#include "cell_index.h"
+#include "period_detector.h"
+#include <vector>
+#include <sstream>
+#include <cassert>
+
+namespace wireworld_systemc
+{
+  // Chain of cells having exactly two neighbours evaluated by a single
+  // process. Cell i of chain is neighbour of cells i - 1 and i + 1, first and
+  // last cells are also neighbours of a cell outside of chain that is read
+  // through an input port, or of each other when chain is a loop. Pulses can
+  // travel in both directions so chain is not a plain shift register: states
+  // are stored as electron and tail bit planes updated 64 cells per word
+  // operation. Only first and last cells own a signal
+  class delay_line: public sc_module
+  {
+  public:
+    SC_HAS_PROCESS(delay_line);
+    inline delay_line(sc_module_name p_name,
+                      const cell_index & p_index,
+                      const std::vector<cell_index::t_cell_id> & p_cells,
+                      const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                      display_if * p_display,
+                      unsigned int & p_nb_electron,
+                      uint64_t * p_hash);
+    inline ~delay_line(void);
+
+    inline void bind_clk(sc_signal<bool> & p_clk);
+    inline unsigned int get_nb_inputs(void)const;
+    inline const cell_index::t_cell_id & get_input_id(const unsigned int & p_index)const;
+    inline void bind_input(sc_signal<bool> & p_signal, const unsigned int & p_index);
+    inline unsigned int get_nb_outputs(void)const;
+    inline cell_index::t_cell_id get_output_id(const unsigned int & p_index)const;
+    inline sc_signal<bool> & get_output(const unsigned int & p_index)const;
+    inline unsigned int get_nb_cells(void)const;
+    inline const wireworld_common::wireworld_types::t_coordinates & get_coordinates(const unsigned int & p_index)const;
+    inline const cell_index::t_cell_id & get_id(const unsigned int & p_index)const;
+    inline wireworld_common::wireworld_types::t_cell_state get_state(const unsigned int & p_index)const;
+    // True when last run had nothing to compute
+    inline bool is_idle(void)const;
+
+    sc_in<bool> m_clk;
+
+    inline void run(void);
+  private:
+    inline bool get_bit(const std::vector<uint64_t> & p_plane,
+                        const unsigned int & p_index)const;
+    inline static wireworld_common::wireworld_types::t_cell_state get_state(const bool & p_electron,
+                                                                             const bool & p_tail);
+
+    // Cell ids in chain order
+    const cell_index & m_index;
+    std::vector<cell_index::t_cell_id> m_ids;
+
+    // Bit i of plane is set when cell i is electron or tail. Bits located
+    // after last cell are kept null
+    std::vector<uint64_t> m_electrons;
+    std::vector<uint64_t> m_tails;
+    std::vector<uint64_t> m_next_electrons;
+    std::vector<uint64_t> m_next_tails;
+    // Number of electrons and tails in chain, nothing happens when it is null
+    // and inputs are not electrons
+    unsigned int m_nb_active;
+    bool m_idle;
+
+    // Empty for a loop, otherwise neighbours of first and last cells
+    std::vector<sc_in<bool>*> m_inputs;
+    std::vector<cell_index::t_cell_id> m_input_ids;
+
+    // Signals of first and last cells, empty for a loop
+    std::vector<std::pair<unsigned int,sc_signal<bool>*>> m_outputs;
+
+    display_if * m_display;
+    unsigned int & m_nb_electron;
+    // Board hash used by period detection, null when disabled
+    uint64_t * m_hash;
+  };
+
+  //----------------------------------------------------------------------------
+  delay_line::delay_line(sc_module_name p_name,
+                         const cell_index & p_index,
+                         const std::vector<cell_index::t_cell_id> & p_cells,
+                         const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                         display_if * p_display,
+                         unsigned int & p_nb_electron,
+                         uint64_t * p_hash):
+    sc_module(p_name),
+    m_clk("clk"),
+    m_index(p_index),
+    m_ids(p_cells),
+    m_electrons((p_cells.size() + 63) / 64,0),
+    m_tails((p_cells.size() + 63) / 64,0),
+    m_nb_active(0),
+    m_idle(false),
+    m_display(p_display),
+    m_nb_electron(p_nb_electron),
+    m_hash(p_hash)
+    {
+      unsigned int l_nb_cells = m_ids.size();
+      if(l_nb_cells < 2)
+        {
+          throw quicky_exception::quicky_logic_exception("Delay line should contain at least two cells",__LINE__,__FILE__);
+        }
+
+      for(unsigned int l_index = 0 ; l_index < l_nb_cells ; ++l_index)
+        {
+          assert(2 == p_index.get_nb_neighbours(m_ids[l_index]));
+          const wireworld_common::wireworld_types::t_cell_state & l_state = p_states[m_ids[l_index]];
+          m_electrons[l_index / 64] |= ((uint64_t)(wireworld_common::wireworld_types::t_cell_state::ELECTRON == l_state)) << (l_index % 64);
+          m_tails[l_index / 64] |= ((uint64_t)(wireworld_common::wireworld_types::t_cell_state::TAIL == l_state)) << (l_index % 64);
+          m_nb_active += wireworld_common::wireworld_types::t_cell_state::COPPER != l_state;
+#ifndef WIREWORLD_HEADLESS
+          if(m_display) m_display->display_cell(get_coordinates(l_index).first,get_coordinates(l_index).second,l_state);
+#endif // WIREWORLD_HEADLESS
+        }
+      m_next_electrons = m_electrons;
+      m_next_tails = m_tails;
+
+      // Neighbours of end cells that do not belong to chain
+      const cell_index::t_cell_id * l_first_neighbours = p_index.get_neighbours(m_ids.front());
+      cell_index::t_cell_id l_first_input = m_ids[1] == l_first_neighbours[0] ? l_first_neighbours[1] : l_first_neighbours[0];
+      const cell_index::t_cell_id * l_last_neighbours = p_index.get_neighbours(m_ids.back());
+      cell_index::t_cell_id l_last_input = m_ids[l_nb_cells - 2] == l_last_neighbours[0] ? l_last_neighbours[1] : l_last_neighbours[0];
+      if(m_ids.back() != l_first_input)
+        {
+          assert(m_ids.front() != l_last_input);
+          m_input_ids.push_back(l_first_input);
+          m_input_ids.push_back(l_last_input);
+          for(auto l_id: m_input_ids)
+            {
+              const wireworld_common::wireworld_types::t_coordinates & l_coordinates = p_index.get_coordinates(l_id);
+              std::stringstream l_stream;
+              l_stream << "from_" << l_coordinates.first << "_" << l_coordinates.second ;
+              m_inputs.push_back(new sc_in<bool>(l_stream.str().c_str()));
+            }
+          for(auto l_index: {0u,l_nb_cells - 1})
+            {
+              std::stringstream l_stream;
+              l_stream << get_coordinates(l_index).first << "_" << get_coordinates(l_index).second;
+              m_outputs.push_back(std::pair<unsigned int,sc_signal<bool>*>(l_index,new sc_signal<bool>(l_stream.str().c_str(),get_bit(m_electrons,l_index))));
+            }
+        }
+
+      SC_METHOD(run);
+      dont_initialize();
+      sensitive << m_clk.pos();
+    }
+
+  //----------------------------------------------------------------------------
+  delay_line::~delay_line(void)
+    {
+      for(auto l_iter: m_inputs)
+        {
+          delete l_iter;
+        }
+      for(auto l_iter: m_outputs)
+        {
+          delete l_iter.second;
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  void delay_line::bind_clk(sc_signal<bool> & p_clk)
+  {
+    m_clk(p_clk);
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int delay_line::get_nb_inputs(void)const
+  {
+    return m_inputs.size();
+  }
+
+  //----------------------------------------------------------------------------
+  const cell_index::t_cell_id & delay_line::get_input_id(const unsigned int & p_index)const
+    {
+      assert(p_index < m_input_ids.size());
+      return m_input_ids[p_index];
+    }
+
+  //----------------------------------------------------------------------------
+  void delay_line::bind_input(sc_signal<bool> & p_signal, const unsigned int & p_index)
+  {
+    assert(p_index < m_inputs.size());
+    (*m_inputs[p_index])(p_signal);
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int delay_line::get_nb_outputs(void)const
+  {
+    return m_outputs.size();
+  }
+
+  //----------------------------------------------------------------------------
+  cell_index::t_cell_id delay_line::get_output_id(const unsigned int & p_index)const
+  {
+    assert(p_index < m_outputs.size());
+    return m_ids[m_outputs[p_index].first];
+  }
+
+  //----------------------------------------------------------------------------
+  sc_signal<bool> & delay_line::get_output(const unsigned int & p_index)const
+    {
+      assert(p_index < m_outputs.size());
+      return *(m_outputs[p_index].second);
+    }
+
+  //----------------------------------------------------------------------------
+  unsigned int delay_line::get_nb_cells(void)const
+  {
+    return m_ids.size();
+  }
+
+  //----------------------------------------------------------------------------
+  const wireworld_common::wireworld_types::t_coordinates & delay_line::get_coordinates(const unsigned int & p_index)const
+    {
+      assert(p_index < m_ids.size());
+      return m_index.get_coordinates(m_ids[p_index]);
+    }
+
+  //----------------------------------------------------------------------------
+  const cell_index::t_cell_id & delay_line::get_id(const unsigned int & p_index)const
+    {
+      assert(p_index < m_ids.size());
+      return m_ids[p_index];
+    }
+
+  //----------------------------------------------------------------------------
+  wireworld_common::wireworld_types::t_cell_state delay_line::get_state(const unsigned int & p_index)const
+  {
+    assert(p_index < m_ids.size());
+    return get_state(get_bit(m_electrons,p_index),get_bit(m_tails,p_index));
+  }
+
+  //----------------------------------------------------------------------------
+  bool delay_line::is_idle(void)const
+  {
+    return m_idle;
+  }
+
+  //----------------------------------------------------------------------------
+  bool delay_line::get_bit(const std::vector<uint64_t> & p_plane,
+                           const unsigned int & p_index)const
+  {
+    return (p_plane[p_index / 64] >> (p_index % 64)) & 0x1;
+  }
+
+  //----------------------------------------------------------------------------
+  wireworld_common::wireworld_types::t_cell_state delay_line::get_state(const bool & p_electron,
+                                                                         const bool & p_tail)
+  {
+    return p_electron ? wireworld_common::wireworld_types::t_cell_state::ELECTRON : (p_tail ? wireworld_common::wireworld_types::t_cell_state::TAIL : wireworld_common::wireworld_types::t_cell_state::COPPER);
+  }
+
+  //----------------------------------------------------------------------------
+  void delay_line::run(void)
+  {
+    unsigned int l_nb_cells = m_ids.size();
+    unsigned int l_nb_words = m_electrons.size();
+
+    // Electron flags of cells located before first cell and after last one
+    uint64_t l_before = m_inputs.empty() ? get_bit(m_electrons,l_nb_cells - 1) : m_inputs[0]->read();
+    uint64_t l_after = m_inputs.empty() ? get_bit(m_electrons,0) : m_inputs[1]->read();
+    m_idle = !m_nb_active && !l_before && !l_after;
+    if(m_idle)
+      {
+        return;
+      }
+
+    unsigned int l_nb_electron = 0;
+    unsigned int l_nb_tail = 0;
+    for(unsigned int l_word = 0 ; l_word < l_nb_words ; ++l_word)
+      {
+        // Electron flags of previous and next cells of each cell
+        uint64_t l_previous = (m_electrons[l_word] << 1) | (l_word ? m_electrons[l_word - 1] >> 63 : l_before);
+        uint64_t l_next = m_electrons[l_word] >> 1;
+        if(l_word + 1 < l_nb_words)
+          {
+            l_next |= m_electrons[l_word + 1] << 63;
+          }
+        else
+          {
+            l_next |= l_after << ((l_nb_cells - 1) % 64);
+          }
+        // With two neighbours a copper cell cannot see three electrons
+        uint64_t l_mask = l_word + 1 < l_nb_words || !(l_nb_cells % 64) ? ~((uint64_t)0) : (((uint64_t)1) << (l_nb_cells % 64)) - 1;
+        m_next_electrons[l_word] = ~(m_electrons[l_word] | m_tails[l_word]) & (l_previous | l_next) & l_mask;
+        m_next_tails[l_word] = m_electrons[l_word];
+        l_nb_electron += __builtin_popcountll(m_next_electrons[l_word]);
+        l_nb_tail += __builtin_popcountll(m_next_tails[l_word]);
+      }
+
+    // Per cell work is only needed to display or hash changes
+    if(m_display || m_hash)
+      {
+        for(unsigned int l_word = 0 ; l_word < l_nb_words ; ++l_word)
+          {
+            uint64_t l_changes = (m_electrons[l_word] ^ m_next_electrons[l_word]) | (m_tails[l_word] ^ m_next_tails[l_word]);
+            while(l_changes)
+              {
+                unsigned int l_index = 64 * l_word + __builtin_ctzll(l_changes);
+                l_changes &= l_changes - 1;
+                wireworld_common::wireworld_types::t_cell_state l_state = get_state(get_bit(m_next_electrons,l_index),get_bit(m_next_tails,l_index));
+                if(m_hash) period_detector::update(*m_hash,get_coordinates(l_index).first,get_coordinates(l_index).second,get_state(l_index),l_state);
+#ifndef WIREWORLD_HEADLESS
+                if(m_display) m_display->display_cell(get_coordinates(l_index).first,get_coordinates(l_index).second,l_state);
+#endif // WIREWORLD_HEADLESS
+              }
+          }
+      }
+
+    // Drive signals of end cells
+    for(auto l_iter: m_outputs)
+      {
+        bool l_electron = get_bit(m_next_electrons,l_iter.first);
+        if(get_bit(m_electrons,l_iter.first) != l_electron)
+          {
+            l_iter.second->write(l_electron);
+          }
+      }
+
+    m_electrons.swap(m_next_electrons);
+    m_tails.swap(m_next_tails);
+    m_nb_active = l_nb_electron + l_nb_tail;
+    m_nb_electron += l_nb_electron;
+  }
+}
+#endif // DELAY_LINE_H
+//EOF
@@ -0,0 +1,184 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef DIRTY_RECTANGLES_H
+#define DIRTY_RECTANGLES_H
+
+#include "SDL.h"
+#include <vector>
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // Board is split in square tiles marked dirty when one of their cells is
+  // redrawn. Consecutive dirty tiles of a tile row are merged in runs, and
+  // runs with same horizontal extent in consecutive tile rows are merged
+  // in rectangles
+  class dirty_rectangles
+  {
+  public:
+    inline dirty_rectangles(const uint32_t & p_width,
+                            const uint32_t & p_height,
+                            const uint32_t & p_tile_size = 16);
+
+    inline void add(const uint32_t & p_x,
+                    const uint32_t & p_y);
+
+    // Ratio of dirty tiles
+    inline double get_coverage(void)const;
+
+    // Screen rectangles covering dirty tiles, a cell being p_scale_x x
+    // p_scale_y pixels. Tiles are clean afterwards
+    inline void extract(const uint32_t & p_scale_x,
+                        const uint32_t & p_scale_y,
+                        std::vector<SDL_Rect> & p_rectangles);
+  private:
+    inline void add_rectangle(const uint32_t & p_x_min,
+                              const uint32_t & p_x_max,
+                              const uint32_t & p_y_min,
+                              const uint32_t & p_y_max,
+                              const uint32_t & p_scale_x,
+                              const uint32_t & p_scale_y,
+                              std::vector<SDL_Rect> & p_rectangles)const;
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_tile_size;
+    uint32_t m_nb_tile_columns;
+    uint32_t m_nb_tile_rows;
+    std::vector<uint8_t> m_tiles;
+    uint32_t m_nb_dirty;
+  };
+
+  //----------------------------------------------------------------------------
+  dirty_rectangles::dirty_rectangles(const uint32_t & p_width,
+                                     const uint32_t & p_height,
+                                     const uint32_t & p_tile_size):
+    m_width(p_width),
+    m_height(p_height),
+    m_tile_size(p_tile_size),
+    m_nb_tile_columns((p_width + p_tile_size - 1) / p_tile_size),
+    m_nb_tile_rows((p_height + p_tile_size - 1) / p_tile_size),
+    m_tiles(m_nb_tile_columns * m_nb_tile_rows,0),
+    m_nb_dirty(0)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  void dirty_rectangles::add(const uint32_t & p_x,
+                             const uint32_t & p_y)
+  {
+    uint8_t & l_tile = m_tiles[(p_y / m_tile_size) * m_nb_tile_columns + p_x / m_tile_size];
+    m_nb_dirty += !l_tile;
+    l_tile = 1;
+  }
+
+  //----------------------------------------------------------------------------
+  double dirty_rectangles::get_coverage(void)const
+  {
+    return m_tiles.empty() ? 0 : ((double)m_nb_dirty) / m_tiles.size();
+  }
+
+  //----------------------------------------------------------------------------
+  void dirty_rectangles::extract(const uint32_t & p_scale_x,
+                                 const uint32_t & p_scale_y,
+                                 std::vector<SDL_Rect> & p_rectangles)
+  {
+    p_rectangles.clear();
+    if(!m_nb_dirty)
+      {
+        return;
+      }
+    // Runs of previous tile row still growing downward: first column, end
+    // column and first row
+    typedef struct
+    {
+      uint32_t m_x_min;
+      uint32_t m_x_max;
+      uint32_t m_y_min;
+    } t_run;
+    std::vector<t_run> l_open;
+    std::vector<t_run> l_next;
+    for(uint32_t l_row = 0 ; l_row <= m_nb_tile_rows ; ++l_row)
+      {
+        l_next.clear();
+        std::vector<t_run>::const_iterator l_open_iter = l_open.begin();
+        uint32_t l_column = 0;
+        while(l_row < m_nb_tile_rows && l_column < m_nb_tile_columns)
+          {
+            if(!m_tiles[l_row * m_nb_tile_columns + l_column])
+              {
+                ++l_column;
+                continue;
+              }
+            uint32_t l_start = l_column;
+            while(l_column < m_nb_tile_columns && m_tiles[l_row * m_nb_tile_columns + l_column])
+              {
+                m_tiles[l_row * m_nb_tile_columns + l_column] = 0;
+                ++l_column;
+              }
+            // Close open runs located before this one
+            while(l_open.end() != l_open_iter && l_open_iter->m_x_min < l_start)
+              {
+                add_rectangle(l_open_iter->m_x_min,l_open_iter->m_x_max,l_open_iter->m_y_min,l_row,p_scale_x,p_scale_y,p_rectangles);
+                ++l_open_iter;
+              }
+            if(l_open.end() != l_open_iter && l_open_iter->m_x_min == l_start && l_open_iter->m_x_max == l_column)
+              {
+                l_next.push_back(*l_open_iter);
+                ++l_open_iter;
+              }
+            else
+              {
+                t_run l_run = {l_start,l_column,l_row};
+                l_next.push_back(l_run);
+              }
+          }
+        for(; l_open.end() != l_open_iter ; ++l_open_iter)
+          {
+            add_rectangle(l_open_iter->m_x_min,l_open_iter->m_x_max,l_open_iter->m_y_min,l_row,p_scale_x,p_scale_y,p_rectangles);
+          }
+        l_open.swap(l_next);
+      }
+    m_nb_dirty = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  void dirty_rectangles::add_rectangle(const uint32_t & p_x_min,
+                                       const uint32_t & p_x_max,
+                                       const uint32_t & p_y_min,
+                                       const uint32_t & p_y_max,
+                                       const uint32_t & p_scale_x,
+                                       const uint32_t & p_scale_y,
+                                       std::vector<SDL_Rect> & p_rectangles)const
+  {
+    // Convert tiles to cells clipped to board then to pixels
+    uint32_t l_x = p_x_min * m_tile_size;
+    uint32_t l_y = p_y_min * m_tile_size;
+    uint32_t l_x_end = p_x_max * m_tile_size < m_width ? p_x_max * m_tile_size : m_width;
+    uint32_t l_y_end = p_y_max * m_tile_size < m_height ? p_y_max * m_tile_size : m_height;
+    SDL_Rect l_rectangle;
+    l_rectangle.x = l_x * p_scale_x;
+    l_rectangle.y = l_y * p_scale_y;
+    l_rectangle.w = (l_x_end - l_x) * p_scale_x;
+    l_rectangle.h = (l_y_end - l_y) * p_scale_y;
+    p_rectangles.push_back(l_rectangle);
+  }
+}
+#endif // DIRTY_RECTANGLES_H
+//EOF
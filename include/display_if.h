@@ -0,0 +1,39 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef DISPLAY_IF_H
+#define DISPLAY_IF_H
+
+#include "wireworld_types.h"
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // Receiver of cell state changes: GUI itself or display thread
+  class display_if
+  {
+  public:
+    virtual void display_cell(const uint32_t & p_x,
+                              const uint32_t & p_y,
+                              const wireworld_common::wireworld_types::t_cell_state & p_state)=0;
+    virtual ~display_if(void){}
+  private:
+  };
+}
+#endif // DISPLAY_IF_H
+//EOF
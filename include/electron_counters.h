@@ -0,0 +1,106 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef ELECTRON_COUNTERS_H
+#define ELECTRON_COUNTERS_H
+
+#include <cassert>
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // Electron counters incremented by cells, partitions and delay lines. Each
+  // group of modules owns a counter alone in a 64 bytes block aligned on 64
+  // bytes, so that groups never write to the same cache line. Counters are
+  // summed and cleared once per generation
+  class electron_counters
+  {
+  public:
+    inline electron_counters(void);
+    inline ~electron_counters(void);
+    electron_counters(const electron_counters &) = delete;
+    electron_counters & operator=(const electron_counters &) = delete;
+
+    // Values are kept, references returned by get are invalidated
+    inline void resize(const unsigned int & p_nb_counters);
+    inline unsigned int & get(const unsigned int & p_counter);
+    inline unsigned int reduce(void);
+  private:
+    struct alignas(64) t_counter
+    {
+      unsigned int m_value;
+    };
+    static_assert(64 == sizeof(t_counter),"Counter is expected to fill a cache line");
+
+    // std::allocator does not honour alignment above alignof(max_align_t)
+    // in C++11 so counters are placed in a buffer aligned by hand
+    char * m_buffer;
+    t_counter * m_counters;
+    unsigned int m_nb_counters;
+  };
+
+  //----------------------------------------------------------------------------
+  electron_counters::electron_counters(void):
+    m_buffer(nullptr),
+    m_counters(nullptr),
+    m_nb_counters(0)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  electron_counters::~electron_counters(void)
+    {
+      delete[] m_buffer;
+    }
+
+  //----------------------------------------------------------------------------
+  void electron_counters::resize(const unsigned int & p_nb_counters)
+  {
+    char * l_buffer = new char[p_nb_counters * sizeof(t_counter) + alignof(t_counter) - 1];
+    t_counter * l_counters = (t_counter*)((((uintptr_t)l_buffer) + alignof(t_counter) - 1) & ~(uintptr_t)(alignof(t_counter) - 1));
+    for(unsigned int l_index = 0 ; l_index < p_nb_counters ; ++l_index)
+      {
+        l_counters[l_index].m_value = l_index < m_nb_counters ? m_counters[l_index].m_value : 0;
+      }
+    delete[] m_buffer;
+    m_buffer = l_buffer;
+    m_counters = l_counters;
+    m_nb_counters = p_nb_counters;
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int & electron_counters::get(const unsigned int & p_counter)
+    {
+      assert(p_counter < m_nb_counters);
+      return m_counters[p_counter].m_value;
+    }
+
+  //----------------------------------------------------------------------------
+  unsigned int electron_counters::reduce(void)
+  {
+    unsigned int l_total = 0;
+    for(unsigned int l_index = 0 ; l_index < m_nb_counters ; ++l_index)
+      {
+        l_total += m_counters[l_index].m_value;
+        m_counters[l_index].m_value = 0;
+      }
+    return l_total;
+  }
+}
+#endif // ELECTRON_COUNTERS_H
+//EOF
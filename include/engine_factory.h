@@ -0,0 +1,67 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef ENGINE_FACTORY_H
+#define ENGINE_FACTORY_H
+
+#include "engine_if.h"
+#include "bitplane_engine.h"
+#include "parallel_engine.h"
+#include "hashlife_engine.h"
+#include "band_engine.h"
+#include "simulation_options.h"
+
+namespace wireworld_systemc
+{
+  class engine_factory
+  {
+  public:
+    inline static engine_if * create(const simulation_options::t_engine & p_engine,
+                                     const cell_index & p_index,
+                                     const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                     const simulation_options & p_options);
+  private:
+  };
+
+  //----------------------------------------------------------------------------
+  engine_if * engine_factory::create(const simulation_options::t_engine & p_engine,
+                                     const cell_index & p_index,
+                                     const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                     const simulation_options & p_options)
+    {
+      switch(p_engine)
+        {
+        case simulation_options::t_engine::BITPLANE:
+          return new bitplane_engine(p_index,p_states);
+          break;
+        case simulation_options::t_engine::PARALLEL:
+          return new parallel_engine(p_index,p_states,p_options.get_nb_threads());
+          break;
+        case simulation_options::t_engine::HASHLIFE:
+          return new hashlife_engine(p_index,p_states);
+          break;
+        case simulation_options::t_engine::BAND:
+          return new band_engine(p_index,p_states,p_options.get_band_height(),p_options.get_band_directory());
+          break;
+        default:
+          throw quicky_exception::quicky_logic_exception("Engine \"" + simulation_options::engine2string(p_engine) + "\" is a SystemC engine",__LINE__,__FILE__);
+        }
+    }
+}
+#endif // ENGINE_FACTORY_H
+//EOF
@@ -0,0 +1,63 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef ENGINE_IF_H
+#define ENGINE_IF_H
+
+#include "wireworld_types.h"
+#include "display_if.h"
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // Interface of simulation engines that do not rely on SystemC kernel
+  class engine_if
+  {
+  public:
+    // Compute next generation
+    virtual void step(void)=0;
+    // Largest number of generations that engine computes faster at once than
+    // one by one
+    virtual uint64_t get_max_jump(void)const{return 1;}
+    // Compute up to p_nb_generations generations, stop at first generation
+    // without electron nor tail. Return number of generations computed
+    virtual uint64_t advance(const uint64_t & p_nb_generations)
+    {
+      for(uint64_t l_index = 0 ; l_index < p_nb_generations ; ++l_index)
+        {
+          step();
+          if(!(get_nb_electron() || get_nb_tail()))
+            {
+              return l_index + 1;
+            }
+        }
+      return p_nb_generations;
+    }
+    // Number of electrons and tails of current generation
+    virtual uint32_t get_nb_electron(void)const=0;
+    virtual uint32_t get_nb_tail(void)const=0;
+    virtual wireworld_common::wireworld_types::t_cell_state get_state(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const=0;
+    // Draw cells whose state changed since previous call, all cells on
+    // first call
+    virtual void display_changes(display_if & p_display)=0;
+    virtual ~engine_if(void){}
+  private:
+  };
+}
+#endif // ENGINE_IF_H
+//EOF
@@ -0,0 +1,311 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef ENGINE_RUNNER_H
+#define ENGINE_RUNNER_H
+
+#include "engine_if.h"
+#include "cell_index.h"
+#include "checkpoint.h"
+#include "async_renderer.h"
+#include "gui_display.h"
+#include "performance_counters.h"
+#include "probe_set.h"
+#include "simulation_options.h"
+#include "wireworld_gui.h"
+#include "wireworld_configuration.h"
+#include "signal_handler.h"
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+
+namespace wireworld_systemc
+{
+  // Generation loop of engines that do not rely on SystemC kernel. It
+  // reproduces what wireworld::clk_management does for SystemC engines
+  class engine_runner: public quicky_utils::signal_handler_listener_if
+  {
+  public:
+    inline engine_runner(engine_if & p_engine,
+                         const cell_index & p_index,
+                         const uint64_t & p_generation,
+                         const wireworld_common::wireworld_configuration & p_conf,
+                         const uint32_t & p_x_max,
+                         const uint32_t & p_y_max,
+                         const wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
+                         const simulation_options & p_options);
+    inline ~engine_runner(void);
+    inline void run(void);
+    inline const uint64_t & get_generation(void)const;
+
+    // Method inherited from signal_handler_listener_if
+    inline void handle(int p_signal);
+    // End of method inherited from signal_handler_listener_if
+  private:
+    // State of every cell indexed by cell id
+    inline void get_states(std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)const;
+    inline void save_checkpoint(void)const;
+    // Number of generations that can be computed from generation
+    // p_generation before something has to be displayed, saved or checked
+    inline uint64_t get_nb_silent_generations(const uint64_t & p_generation)const;
+    // Record probes at current generation, return true if one of them
+    // requests simulation stop
+    inline bool record_probes(void);
+
+    engine_if & m_engine;
+    const cell_index & m_index;
+    uint64_t m_generation;
+    wireworld_common::wireworld_gui m_gui;
+    gui_display m_gui_display;
+    bool m_headless;
+    // Display thread, it receives changes of engine instead of GUI when it
+    // exists
+    async_renderer * m_renderer;
+    // Where engine reports its changes, null when headless
+    display_if * m_display;
+    // Only created when statistics are requested
+    performance_counters * m_counters;
+    // Only created when probes are requested
+    probe_set * m_probes;
+    std::string m_probe_output_file;
+    wireworld_common::wireworld_configuration m_config;
+    checkpoint m_checkpoint;
+    bool m_stop;
+    quicky_utils::signal_handler m_signal_handler;
+  };
+
+  //----------------------------------------------------------------------------
+  engine_runner::engine_runner(engine_if & p_engine,
+                               const cell_index & p_index,
+                               const uint64_t & p_generation,
+                               const wireworld_common::wireworld_configuration & p_conf,
+                               const uint32_t & p_x_max,
+                               const uint32_t & p_y_max,
+                               const wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
+                               const simulation_options & p_options):
+    m_engine(p_engine),
+    m_index(p_index),
+    m_generation(p_generation),
+    m_gui_display(m_gui,p_x_max + 2,p_y_max + 2),
+    m_headless(p_options.is_headless()),
+    m_renderer(nullptr),
+    m_display(nullptr),
+    m_counters(nullptr),
+    m_probes(nullptr),
+    m_probe_output_file(p_options.get_probe_output_file()),
+    m_config(p_conf),
+    m_checkpoint(p_options.get_checkpoint_file(),p_options.get_checkpoint_interval(),p_generation,p_index,m_config,p_x_max,p_y_max,p_inactive_cells),
+    m_stop(false),
+    m_signal_handler(*this)
+    {
+      if(!p_options.get_stats_file().empty())
+        {
+          m_counters = new performance_counters(p_options.get_stats_file(),p_options.get_stats_interval());
+        }
+      if(p_options.is_probe())
+        {
+          m_probes = new probe_set(p_options.get_probe_file(),m_index);
+        }
+      if(m_headless)
+        {
+          return;
+        }
+      m_gui.createWindow(p_x_max + 2,p_y_max + 2);
+      if(p_options.is_async_display())
+        {
+          m_renderer = new async_renderer(m_gui,p_x_max + 2,p_y_max + 2,m_config.get_display_duration());
+          m_display = m_renderer;
+        }
+      else
+        {
+          m_display = &m_gui_display;
+        }
+      for(auto l_iter:p_inactive_cells)
+        {
+          m_display->display_cell(l_iter.first,l_iter.second,wireworld_common::wireworld_types::t_cell_state::COPPER);
+        }
+      m_engine.display_changes(*m_display);
+      if(m_renderer)
+        {
+          m_renderer->push_frame();
+        }
+      else
+        {
+          m_gui_display.update_screen();
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  engine_runner::~engine_runner(void)
+    {
+      delete m_renderer;
+      delete m_counters;
+      delete m_probes;
+    }
+
+  //----------------------------------------------------------------------------
+  void engine_runner::run(void)
+  {
+    if(m_counters)
+      {
+        m_counters->end_elaboration();
+      }
+    while(true)
+      {
+        // GUI refresh management
+        if(!m_headless && m_generation >= m_config.get_start_cycle() && !(m_generation % m_config.get_refresh_interval()))
+          {
+#ifdef DEBUG_MESSAGES
+            std::cout << m_generation << " : " << m_engine.get_nb_electron() << "E\t" << m_engine.get_nb_tail() << "Q" << std::endl ;
+#endif // DEBUG_MESSAGES
+            if(m_counters)
+              {
+                m_counters->start_gui();
+              }
+            m_engine.display_changes(*m_display);
+            if(m_renderer)
+              {
+                m_renderer->push_frame();
+              }
+            else
+              {
+                m_gui_display.update_screen();
+                SDL_Delay(m_config.get_display_duration());
+              }
+            if(m_counters)
+              {
+                m_counters->end_gui();
+              }
+          }
+
+        // Sample stop request once so that snapshot and stop agree
+        bool l_stop = m_stop;
+        if(m_checkpoint.is_due(m_generation,l_stop))
+          {
+            save_checkpoint();
+          }
+        if(m_probes && record_probes())
+          {
+            l_stop = true;
+          }
+        ++m_generation;
+        if(l_stop || !(m_engine.get_nb_electron() || m_engine.get_nb_tail()) || m_generation > m_config.get_nb_max_cycle())
+          {
+            break;
+          }
+        uint64_t l_nb_active_cells = m_engine.get_nb_electron() + m_engine.get_nb_tail();
+        uint64_t l_nb_generations = 1;
+        // Probes are recorded every generation
+        if(1 == m_engine.get_max_jump() || m_probes)
+          {
+            m_engine.step();
+          }
+        else
+          {
+            // Engine state is generation m_generation - 1. Engine stops at
+            // first generation without activity so that simulation ends at
+            // the same generation as when stepping
+            l_nb_generations = m_engine.advance(get_nb_silent_generations(m_generation - 1));
+            m_generation += l_nb_generations - 1;
+          }
+        if(m_counters)
+          {
+            // Engines able to jump do not update cells one by one
+            if(1 == m_engine.get_max_jump())
+              {
+                m_counters->generation(m_generation,l_nb_generations,0,l_nb_generations * m_index.get_nb_cells(),l_nb_active_cells,0);
+              }
+            else
+              {
+                m_counters->generation(m_generation,l_nb_generations,l_nb_generations,0,l_nb_active_cells,0);
+              }
+          }
+      }
+    if(m_counters)
+      {
+        m_counters->summary(m_generation - 1);
+      }
+    if(m_probes)
+      {
+        m_probes->save(m_probe_output_file,m_generation - 1);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  const uint64_t & engine_runner::get_generation(void)const
+    {
+      return m_generation;
+    }
+
+  //----------------------------------------------------------------------------
+  void engine_runner::get_states(std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)const
+  {
+    p_states.resize(m_index.get_nb_cells());
+    for(cell_index::t_cell_id l_id = 0 ; l_id < m_index.get_nb_cells() ; ++l_id)
+      {
+        p_states[l_id] = m_engine.get_state(m_index.get_coordinates(l_id));
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void engine_runner::save_checkpoint(void)const
+  {
+    std::vector<wireworld_common::wireworld_types::t_cell_state> l_states;
+    get_states(l_states);
+    m_checkpoint.save(m_generation,l_states);
+  }
+
+  //----------------------------------------------------------------------------
+  uint64_t engine_runner::get_nb_silent_generations(const uint64_t & p_generation)const
+  {
+    uint64_t l_next = m_config.get_nb_max_cycle();
+    if(!m_headless)
+      {
+        uint64_t l_display = std::max(p_generation + 1,(uint64_t)m_config.get_start_cycle());
+        l_display = ((l_display + m_config.get_refresh_interval() - 1) / m_config.get_refresh_interval()) * m_config.get_refresh_interval();
+        l_next = std::min(l_next,l_display);
+      }
+    l_next = std::min(l_next,m_checkpoint.get_next_generation(p_generation));
+    assert(l_next > p_generation);
+    return std::min(l_next - p_generation,m_engine.get_max_jump());
+  }
+
+  //----------------------------------------------------------------------------
+  bool engine_runner::record_probes(void)
+  {
+    bool l_stop = false;
+    for(unsigned int l_probe = 0 ; l_probe < m_probes->get_nb_probes() ; ++l_probe)
+      {
+        if(m_probes->record(l_probe,m_generation,m_engine.get_state(m_index.get_coordinates(m_probes->get_id(l_probe)))) && !l_stop)
+          {
+            m_probes->report_stop(l_probe,m_generation);
+            l_stop = true;
+          }
+      }
+    return l_stop;
+  }
+
+  //----------------------------------------------------------------------------
+  void engine_runner::handle(int p_signal)
+  {
+    std::cout << "STOP requested !" << std::endl ;
+    m_stop = true;
+  }
+}
+#endif // ENGINE_RUNNER_H
+//EOF
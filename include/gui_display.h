@@ -0,0 +1,98 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef GUI_DISPLAY_H
+#define GUI_DISPLAY_H
+
+#include "display_if.h"
+#include "dirty_rectangles.h"
+#include "wireworld_gui.h"
+#include "SDL.h"
+#include <vector>
+
+namespace wireworld_systemc
+{
+  // Cells are drawn as soon as they change. Only screen areas containing
+  // cells drawn since last update are updated so that display cost depends
+  // on activity and not on board size
+  class gui_display: public display_if
+  {
+  public:
+    inline gui_display(wireworld_common::wireworld_gui & p_gui,
+                       const uint32_t & p_width,
+                       const uint32_t & p_height);
+
+    // Method inherited from display_if
+    inline void display_cell(const uint32_t & p_x,
+                             const uint32_t & p_y,
+                             const wireworld_common::wireworld_types::t_cell_state & p_state);
+    // End of method inherited from display_if
+
+    // Show on screen cells drawn since last update
+    inline void update_screen(void);
+  private:
+    wireworld_common::wireworld_gui & m_gui;
+    uint32_t m_width;
+    uint32_t m_height;
+    dirty_rectangles m_dirty;
+    std::vector<SDL_Rect> m_rectangles;
+  };
+
+  //----------------------------------------------------------------------------
+  gui_display::gui_display(wireworld_common::wireworld_gui & p_gui,
+                           const uint32_t & p_width,
+                           const uint32_t & p_height):
+    m_gui(p_gui),
+    m_width(p_width),
+    m_height(p_height),
+    m_dirty(p_width,p_height)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  void gui_display::display_cell(const uint32_t & p_x,
+                                 const uint32_t & p_y,
+                                 const wireworld_common::wireworld_types::t_cell_state & p_state)
+  {
+    m_gui.displayCell(p_x,p_y,p_state);
+    m_dirty.add(p_x,p_y);
+  }
+
+  //----------------------------------------------------------------------------
+  void gui_display::update_screen(void)
+  {
+    // Updating many small areas costs more than a full refresh
+    SDL_Surface * l_screen = SDL_GetVideoSurface();
+    if(!l_screen || m_dirty.get_coverage() > 0.5)
+      {
+        m_dirty.extract(1,1,m_rectangles);
+        m_gui.refresh();
+        return;
+      }
+    // GUI may draw a cell with several pixels
+    uint32_t l_scale_x = l_screen->w / m_width ? l_screen->w / m_width : 1;
+    uint32_t l_scale_y = l_screen->h / m_height ? l_screen->h / m_height : 1;
+    m_dirty.extract(l_scale_x,l_scale_y,m_rectangles);
+    if(m_rectangles.size())
+      {
+        SDL_UpdateRects(l_screen,m_rectangles.size(),&m_rectangles[0]);
+      }
+  }
+}
+#endif // GUI_DISPLAY_H
+//EOF
@@ -0,0 +1,166 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef HARDWARE_COUNTERS_H
+#define HARDWARE_COUNTERS_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif // __linux__
+
+namespace wireworld_systemc
+{
+  // Cache events of process counted by processor performance counters
+  // through perf_event_open. Threads created after construction are counted
+  // too. Counting starts disabled. Events that cannot be counted, because
+  // of perf_event_paranoid setting, virtualisation or operating system, are
+  // reported as unavailable
+  class hardware_counters
+  {
+  public:
+    typedef enum class event {CACHE_REFERENCES=0, CACHE_MISSES, L1D_READ_MISSES} t_event;
+    static const unsigned int m_nb_events = 3;
+
+    inline hardware_counters(void);
+    inline ~hardware_counters(void);
+    hardware_counters(const hardware_counters &) = delete;
+    hardware_counters & operator=(const hardware_counters &) = delete;
+
+    inline void enable(void);
+    inline void disable(void);
+    // Count of event since construction, false if event is unavailable
+    inline bool get(const t_event & p_event,
+                    uint64_t & p_value)const;
+
+    inline static std::string event2string(const t_event & p_event);
+  private:
+    int m_fds[m_nb_events];
+  };
+
+  //----------------------------------------------------------------------------
+  hardware_counters::hardware_counters(void)
+    {
+      for(unsigned int l_event = 0 ; l_event < m_nb_events ; ++l_event)
+        {
+          m_fds[l_event] = -1;
+#ifdef __linux__
+          struct perf_event_attr l_attr;
+          memset(&l_attr,0,sizeof(l_attr));
+          l_attr.size = sizeof(l_attr);
+          l_attr.disabled = 1;
+          l_attr.inherit = 1;
+          l_attr.exclude_kernel = 1;
+          l_attr.exclude_hv = 1;
+          switch((t_event)l_event)
+            {
+            case t_event::CACHE_REFERENCES:
+              l_attr.type = PERF_TYPE_HARDWARE;
+              l_attr.config = PERF_COUNT_HW_CACHE_REFERENCES;
+              break;
+            case t_event::CACHE_MISSES:
+              l_attr.type = PERF_TYPE_HARDWARE;
+              l_attr.config = PERF_COUNT_HW_CACHE_MISSES;
+              break;
+            case t_event::L1D_READ_MISSES:
+              l_attr.type = PERF_TYPE_HW_CACHE;
+              l_attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+              break;
+            }
+          m_fds[l_event] = syscall(__NR_perf_event_open,&l_attr,0,-1,-1,0);
+#endif // __linux__
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  hardware_counters::~hardware_counters(void)
+    {
+#ifdef __linux__
+      for(unsigned int l_event = 0 ; l_event < m_nb_events ; ++l_event)
+        {
+          if(m_fds[l_event] >= 0)
+            {
+              close(m_fds[l_event]);
+            }
+        }
+#endif // __linux__
+    }
+
+  //----------------------------------------------------------------------------
+  void hardware_counters::enable(void)
+  {
+#ifdef __linux__
+    for(unsigned int l_event = 0 ; l_event < m_nb_events ; ++l_event)
+      {
+        if(m_fds[l_event] >= 0)
+          {
+            ioctl(m_fds[l_event],PERF_EVENT_IOC_ENABLE,0);
+          }
+      }
+#endif // __linux__
+  }
+
+  //----------------------------------------------------------------------------
+  void hardware_counters::disable(void)
+  {
+#ifdef __linux__
+    for(unsigned int l_event = 0 ; l_event < m_nb_events ; ++l_event)
+      {
+        if(m_fds[l_event] >= 0)
+          {
+            ioctl(m_fds[l_event],PERF_EVENT_IOC_DISABLE,0);
+          }
+      }
+#endif // __linux__
+  }
+
+  //----------------------------------------------------------------------------
+  bool hardware_counters::get(const t_event & p_event,
+                              uint64_t & p_value)const
+  {
+    p_value = 0;
+#ifdef __linux__
+    int l_fd = m_fds[(unsigned int)p_event];
+    return l_fd >= 0 && (ssize_t)sizeof(p_value) == read(l_fd,&p_value,sizeof(p_value));
+#else
+    return false;
+#endif // __linux__
+  }
+
+  //----------------------------------------------------------------------------
+  std::string hardware_counters::event2string(const t_event & p_event)
+  {
+    switch(p_event)
+      {
+      case t_event::CACHE_REFERENCES:
+        return "cache_references";
+      case t_event::CACHE_MISSES:
+        return "cache_misses";
+      case t_event::L1D_READ_MISSES:
+        return "l1d_read_misses";
+      }
+    return "";
+  }
+}
+#endif // HARDWARE_COUNTERS_H
+//EOF
@@ -0,0 +1,611 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef HASHLIFE_ENGINE_H
+#define HASHLIFE_ENGINE_H
+
+#include "engine_if.h"
+#include "cell_index.h"
+#include "bitplane_engine.h"
+#include "quicky_exception.h"
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <cassert>
+
+namespace wireworld_systemc
+{
+  // Engine representing board as a quadtree of hash-consed macro cells. Node
+  // of level k covers 2^k x 2^k positions and identical sub-squares share the
+  // same node. Evolution of the centre of a node is memoized so periodic
+  // circuits are computed once per distinct configuration and simulation can
+  // jump 2^j generations at once. As electrons never leave copper the board
+  // never grows
+  class hashlife_engine: public engine_if
+  {
+  public:
+    inline hashlife_engine(const cell_index & p_index,
+                           const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states);
+
+    // Methods inherited from engine_if
+    inline void step(void);
+    inline uint64_t get_max_jump(void)const;
+    inline uint64_t advance(const uint64_t & p_nb_generations);
+    inline uint32_t get_nb_electron(void)const;
+    inline uint32_t get_nb_tail(void)const;
+    inline wireworld_common::wireworld_types::t_cell_state get_state(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const;
+    inline void display_changes(display_if & p_display);
+    // End of methods inherited from engine_if
+  private:
+    typedef uint32_t t_node_id;
+
+    // Level 0 nodes are single positions
+    typedef enum class leaf {EMPTY=0, COPPER, ELECTRON, TAIL} t_leaf;
+
+    class node
+    {
+    public:
+      // North west, north east, south west and south east quarters
+      t_node_id m_children[4];
+      // Number of non empty positions, electrons and tails
+      uint32_t m_nb_cells;
+      uint32_t m_nb_electron;
+      uint32_t m_nb_tail;
+      uint8_t m_level;
+    };
+
+    class node_hash
+    {
+    public:
+      inline size_t operator()(const std::pair<uint64_t,uint64_t> & p_key)const
+      {
+        return (size_t)(p_key.first * 0x9E3779B97F4A7C15ULL ^ (p_key.second + (p_key.first >> 29)) * 0xC2B2AE3D27D4EB4FULL);
+      }
+    };
+
+    typedef std::unordered_map<std::pair<uint64_t,uint64_t>,t_node_id,node_hash> t_node_table;
+
+    inline t_node_id get_node(const t_node_id & p_nw,
+                              const t_node_id & p_ne,
+                              const t_node_id & p_sw,
+                              const t_node_id & p_se);
+    inline t_node_id get_empty(const uint8_t & p_level);
+    inline t_node_id build(const uint8_t & p_level,
+                           const uint32_t & p_x,
+                           const uint32_t & p_y,
+                           const std::vector<std::pair<wireworld_common::wireworld_types::t_coordinates,t_leaf>> & p_cells);
+
+    // Node of level + 1 whose centre is p_node
+    inline t_node_id get_centered(const t_node_id & p_node);
+    // Centre of p_node, one level below
+    inline t_node_id get_center(const t_node_id & p_node);
+
+    // Centre of p_node, one level below, 2^p_log_step generations later.
+    // p_log_step should not exceed level - 2
+    inline t_node_id get_result(const t_node_id & p_node,
+                                const uint8_t & p_log_step);
+    inline t_node_id compute_base(const t_node_id & p_node);
+    // Root of board 2^p_log_step generations after current one
+    inline t_node_id jump(const uint8_t & p_log_step);
+    // Make p_root current board and collect nodes when tables are too big
+    inline void set_root(const t_node_id & p_root);
+
+    // Keep only nodes reachable from root when tables become too big
+    inline void collect(void);
+    inline t_node_id copy(const t_node_id & p_node,
+                          std::vector<t_node_id> & p_new_ids,
+                          std::vector<node> & p_nodes);
+
+    inline t_leaf get_leaf(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const;
+    // Draw cells of p_node located at (p_x,p_y) that differ in p_old, which
+    // is m_no_node if nothing has been displayed. Identical subtrees share
+    // their node so unchanged areas are skipped
+    inline void display_changes(display_if & p_display,
+                                const t_node_id & p_old,
+                                const t_node_id & p_node,
+                                const uint32_t & p_x,
+                                const uint32_t & p_y)const;
+
+    std::vector<node> m_nodes;
+    t_node_table m_node_table;
+    // Memoized results, key is node id and log2 of step
+    std::unordered_map<uint64_t,t_node_id> m_results;
+    std::vector<t_node_id> m_empty;
+
+    t_node_id m_root;
+    // Root of last displayed generation, kept alive by collection
+    t_node_id m_displayed_root;
+    static const t_node_id m_no_node = 0xFFFFFFFFU;
+    uint8_t m_root_level;
+    size_t m_collect_threshold;
+  };
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::hashlife_engine(const cell_index & p_index,
+                                   const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states):
+    m_root(0),
+    m_displayed_root(m_no_node),
+    m_root_level(2),
+    m_collect_threshold(1 << 22)
+    {
+      bitplane_engine::check_topology(p_index,"hashlife");
+
+      // Leaves
+      for(unsigned int l_leaf = 0 ; l_leaf < 4 ; ++l_leaf)
+        {
+          node l_node = {{0,0,0,0},(t_leaf)l_leaf != t_leaf::EMPTY,(t_leaf)l_leaf == t_leaf::ELECTRON,(t_leaf)l_leaf == t_leaf::TAIL,0};
+          m_nodes.push_back(l_node);
+        }
+      m_empty.push_back((t_node_id)t_leaf::EMPTY);
+
+      std::vector<std::pair<wireworld_common::wireworld_types::t_coordinates,t_leaf>> l_cells;
+      l_cells.reserve(p_index.get_nb_cells());
+      uint32_t l_max = 0;
+      for(cell_index::t_cell_id l_id = 0 ; l_id < p_index.get_nb_cells() ; ++l_id)
+        {
+          const wireworld_common::wireworld_types::t_coordinates & l_coordinates = p_index.get_coordinates(l_id);
+          t_leaf l_leaf = t_leaf::COPPER;
+          if(wireworld_common::wireworld_types::t_cell_state::ELECTRON == p_states[l_id]) l_leaf = t_leaf::ELECTRON;
+          else if(wireworld_common::wireworld_types::t_cell_state::TAIL == p_states[l_id]) l_leaf = t_leaf::TAIL;
+          l_cells.push_back(std::pair<wireworld_common::wireworld_types::t_coordinates,t_leaf>(l_coordinates,l_leaf));
+          if(l_coordinates.first > l_max) l_max = l_coordinates.first;
+          if(l_coordinates.second > l_max) l_max = l_coordinates.second;
+        }
+      while(l_max >= (((uint64_t)1) << m_root_level))
+        {
+          ++m_root_level;
+        }
+      m_root = build(m_root_level,0,0,l_cells);
+      std::cout << "Hashlife engine : root level " << (unsigned int)m_root_level << ", " << m_nodes.size() << " nodes" << std::endl ;
+    }
+
+  //----------------------------------------------------------------------------
+  void hashlife_engine::step(void)
+  {
+    set_root(jump(0));
+  }
+
+  //----------------------------------------------------------------------------
+  uint64_t hashlife_engine::get_max_jump(void)const
+  {
+    return ((uint64_t)1) << 62;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64_t hashlife_engine::advance(const uint64_t & p_nb_generations)
+  {
+    uint64_t l_nb_generations = 0;
+    for(uint8_t l_log_step = 0 ; l_log_step < 63 ; ++l_log_step)
+      {
+        if(!((p_nb_generations >> l_log_step) & 1))
+          {
+            continue;
+          }
+        t_node_id l_root = jump(l_log_step);
+        if(m_nodes[l_root].m_nb_electron || m_nodes[l_root].m_nb_tail)
+          {
+            set_root(l_root);
+            l_nb_generations += ((uint64_t)1) << l_log_step;
+            continue;
+          }
+        // Board dies during this jump, once empty it stays empty so halves
+        // are tried to reach last active generation
+        while(l_log_step--)
+          {
+            l_root = jump(l_log_step);
+            if(m_nodes[l_root].m_nb_electron || m_nodes[l_root].m_nb_tail)
+              {
+                set_root(l_root);
+                l_nb_generations += ((uint64_t)1) << l_log_step;
+              }
+          }
+        set_root(jump(0));
+        return l_nb_generations + 1;
+      }
+    return l_nb_generations;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t hashlife_engine::get_nb_electron(void)const
+  {
+    return m_nodes[m_root].m_nb_electron;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t hashlife_engine::get_nb_tail(void)const
+  {
+    return m_nodes[m_root].m_nb_tail;
+  }
+
+  //----------------------------------------------------------------------------
+  wireworld_common::wireworld_types::t_cell_state hashlife_engine::get_state(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const
+    {
+      switch(get_leaf(p_coordinates))
+        {
+        case t_leaf::ELECTRON:
+          return wireworld_common::wireworld_types::t_cell_state::ELECTRON;
+        case t_leaf::TAIL:
+          return wireworld_common::wireworld_types::t_cell_state::TAIL;
+        default:
+          return wireworld_common::wireworld_types::t_cell_state::COPPER;
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  void hashlife_engine::display_changes(display_if & p_display)
+  {
+    display_changes(p_display,m_displayed_root,m_root,0,0);
+    m_displayed_root = m_root;
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::get_node(const t_node_id & p_nw,
+                                                       const t_node_id & p_ne,
+                                                       const t_node_id & p_sw,
+                                                       const t_node_id & p_se)
+  {
+    std::pair<uint64_t,uint64_t> l_key((((uint64_t)p_nw) << 32) | p_ne,(((uint64_t)p_sw) << 32) | p_se);
+    t_node_table::const_iterator l_iter = m_node_table.find(l_key);
+    if(m_node_table.end() != l_iter)
+      {
+        return l_iter->second;
+      }
+    node l_node = {{p_nw,p_ne,p_sw,p_se},
+                   m_nodes[p_nw].m_nb_cells + m_nodes[p_ne].m_nb_cells + m_nodes[p_sw].m_nb_cells + m_nodes[p_se].m_nb_cells,
+                   m_nodes[p_nw].m_nb_electron + m_nodes[p_ne].m_nb_electron + m_nodes[p_sw].m_nb_electron + m_nodes[p_se].m_nb_electron,
+                   m_nodes[p_nw].m_nb_tail + m_nodes[p_ne].m_nb_tail + m_nodes[p_sw].m_nb_tail + m_nodes[p_se].m_nb_tail,
+                   (uint8_t)(m_nodes[p_nw].m_level + 1)};
+    if(m_nodes.size() > 0xFFFFFFFEU)
+      {
+        throw quicky_exception::quicky_runtime_exception("Hashlife node table is full",__LINE__,__FILE__);
+      }
+    t_node_id l_id = m_nodes.size();
+    m_nodes.push_back(l_node);
+    m_node_table.insert(t_node_table::value_type(l_key,l_id));
+    return l_id;
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::get_empty(const uint8_t & p_level)
+  {
+    while(m_empty.size() <= p_level)
+      {
+        t_node_id l_child = m_empty.back();
+        m_empty.push_back(get_node(l_child,l_child,l_child,l_child));
+      }
+    return m_empty[p_level];
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::build(const uint8_t & p_level,
+                                                    const uint32_t & p_x,
+                                                    const uint32_t & p_y,
+                                                    const std::vector<std::pair<wireworld_common::wireworld_types::t_coordinates,t_leaf>> & p_cells)
+  {
+    if(p_cells.empty())
+      {
+        return get_empty(p_level);
+      }
+    if(!p_level)
+      {
+        assert(1 == p_cells.size());
+        return (t_node_id)p_cells.front().second;
+      }
+    uint32_t l_half = ((uint32_t)1) << (p_level - 1);
+    std::vector<std::pair<wireworld_common::wireworld_types::t_coordinates,t_leaf>> l_quarters[4];
+    for(auto l_iter: p_cells)
+      {
+        unsigned int l_quarter = (l_iter.first.first >= p_x + l_half) + 2 * (l_iter.first.second >= p_y + l_half);
+        l_quarters[l_quarter].push_back(l_iter);
+      }
+    t_node_id l_children[4];
+    for(unsigned int l_quarter = 0 ; l_quarter < 4 ; ++l_quarter)
+      {
+        l_children[l_quarter] = build(p_level - 1,p_x + (l_quarter & 1) * l_half,p_y + (l_quarter >> 1) * l_half,l_quarters[l_quarter]);
+      }
+    return get_node(l_children[0],l_children[1],l_children[2],l_children[3]);
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::get_centered(const t_node_id & p_node)
+  {
+    uint8_t l_level = m_nodes[p_node].m_level;
+    t_node_id l_empty = get_empty(l_level - 1);
+    // Children are copied as get_node can reallocate m_nodes
+    t_node_id l_children[4] = {m_nodes[p_node].m_children[0],m_nodes[p_node].m_children[1],m_nodes[p_node].m_children[2],m_nodes[p_node].m_children[3]};
+    t_node_id l_nw = get_node(l_empty,l_empty,l_empty,l_children[0]);
+    t_node_id l_ne = get_node(l_empty,l_empty,l_children[1],l_empty);
+    t_node_id l_sw = get_node(l_empty,l_children[2],l_empty,l_empty);
+    t_node_id l_se = get_node(l_children[3],l_empty,l_empty,l_empty);
+    return get_node(l_nw,l_ne,l_sw,l_se);
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::get_center(const t_node_id & p_node)
+  {
+    t_node_id l_nw = m_nodes[p_node].m_children[0];
+    t_node_id l_ne = m_nodes[p_node].m_children[1];
+    t_node_id l_sw = m_nodes[p_node].m_children[2];
+    t_node_id l_se = m_nodes[p_node].m_children[3];
+    return get_node(m_nodes[l_nw].m_children[3],m_nodes[l_ne].m_children[2],m_nodes[l_sw].m_children[1],m_nodes[l_se].m_children[0]);
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::get_result(const t_node_id & p_node,
+                                                         const uint8_t & p_log_step)
+  {
+    uint8_t l_level = m_nodes[p_node].m_level;
+    assert(l_level >= 2 && p_log_step + 2 <= l_level);
+    if(!m_nodes[p_node].m_nb_electron && !m_nodes[p_node].m_nb_tail)
+      {
+        // Nothing moves
+        return get_center(p_node);
+      }
+    uint64_t l_key = (((uint64_t)p_node) << 6) | p_log_step;
+    std::unordered_map<uint64_t,t_node_id>::const_iterator l_iter = m_results.find(l_key);
+    if(m_results.end() != l_iter)
+      {
+        return l_iter->second;
+      }
+
+    t_node_id l_result;
+    if(2 == l_level)
+      {
+        l_result = compute_base(p_node);
+      }
+    else
+      {
+        // Nine overlapping sub-nodes of level - 1
+        t_node_id l_nw = m_nodes[p_node].m_children[0];
+        t_node_id l_ne = m_nodes[p_node].m_children[1];
+        t_node_id l_sw = m_nodes[p_node].m_children[2];
+        t_node_id l_se = m_nodes[p_node].m_children[3];
+        const t_node_id l_nws[4] = {m_nodes[l_nw].m_children[0],m_nodes[l_nw].m_children[1],m_nodes[l_nw].m_children[2],m_nodes[l_nw].m_children[3]};
+        const t_node_id l_nes[4] = {m_nodes[l_ne].m_children[0],m_nodes[l_ne].m_children[1],m_nodes[l_ne].m_children[2],m_nodes[l_ne].m_children[3]};
+        const t_node_id l_sws[4] = {m_nodes[l_sw].m_children[0],m_nodes[l_sw].m_children[1],m_nodes[l_sw].m_children[2],m_nodes[l_sw].m_children[3]};
+        const t_node_id l_ses[4] = {m_nodes[l_se].m_children[0],m_nodes[l_se].m_children[1],m_nodes[l_se].m_children[2],m_nodes[l_se].m_children[3]};
+        t_node_id l_subs[9] =
+          {
+            l_nw,
+            get_node(l_nws[1],l_nes[0],l_nws[3],l_nes[2]),
+            l_ne,
+            get_node(l_nws[2],l_nws[3],l_sws[0],l_sws[1]),
+            get_node(l_nws[3],l_nes[2],l_sws[1],l_ses[0]),
+            get_node(l_nes[2],l_nes[3],l_ses[0],l_ses[1]),
+            l_sw,
+            get_node(l_sws[1],l_ses[0],l_sws[3],l_ses[2]),
+            l_se
+          };
+
+        // At full speed both halves advance, otherwise first half does the
+        // whole step and second half only extracts centres
+        bool l_full_speed = p_log_step + 2 == l_level;
+        uint8_t l_log_step = l_full_speed ? p_log_step - 1 : p_log_step;
+        t_node_id l_results[9];
+        for(unsigned int l_index = 0 ; l_index < 9 ; ++l_index)
+          {
+            l_results[l_index] = get_result(l_subs[l_index],l_log_step);
+          }
+        t_node_id l_quarters[4] =
+          {
+            get_node(l_results[0],l_results[1],l_results[3],l_results[4]),
+            get_node(l_results[1],l_results[2],l_results[4],l_results[5]),
+            get_node(l_results[3],l_results[4],l_results[6],l_results[7]),
+            get_node(l_results[4],l_results[5],l_results[7],l_results[8])
+          };
+        for(unsigned int l_index = 0 ; l_index < 4 ; ++l_index)
+          {
+            l_quarters[l_index] = l_full_speed ? get_result(l_quarters[l_index],l_log_step) : get_center(l_quarters[l_index]);
+          }
+        l_result = get_node(l_quarters[0],l_quarters[1],l_quarters[2],l_quarters[3]);
+      }
+    m_results.insert(std::unordered_map<uint64_t,t_node_id>::value_type(l_key,l_result));
+    return l_result;
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::compute_base(const t_node_id & p_node)
+  {
+    // 4 x 4 positions, one generation of the 2 x 2 centre
+    t_leaf l_grid[4][4];
+    for(unsigned int l_quarter = 0 ; l_quarter < 4 ; ++l_quarter)
+      {
+        const node & l_child = m_nodes[m_nodes[p_node].m_children[l_quarter]];
+        for(unsigned int l_sub = 0 ; l_sub < 4 ; ++l_sub)
+          {
+            l_grid[2 * (l_quarter >> 1) + (l_sub >> 1)][2 * (l_quarter & 1) + (l_sub & 1)] = (t_leaf)l_child.m_children[l_sub];
+          }
+      }
+    t_node_id l_center[4];
+    for(unsigned int l_index = 0 ; l_index < 4 ; ++l_index)
+      {
+        unsigned int l_y = 1 + (l_index >> 1);
+        unsigned int l_x = 1 + (l_index & 1);
+        t_leaf l_leaf = l_grid[l_y][l_x];
+        switch(l_leaf)
+          {
+          case t_leaf::ELECTRON:
+            l_leaf = t_leaf::TAIL;
+            break;
+          case t_leaf::TAIL:
+            l_leaf = t_leaf::COPPER;
+            break;
+          case t_leaf::COPPER:
+            {
+              unsigned int l_total = 0;
+              for(unsigned int l_y_index = l_y - 1 ; l_y_index <= l_y + 1 ; ++l_y_index)
+                {
+                  for(unsigned int l_x_index = l_x - 1 ; l_x_index <= l_x + 1 ; ++l_x_index)
+                    {
+                      l_total += t_leaf::ELECTRON == l_grid[l_y_index][l_x_index];
+                    }
+                }
+              if(l_total && l_total < 3)
+                {
+                  l_leaf = t_leaf::ELECTRON;
+                }
+            }
+            break;
+          default:
+            break;
+          }
+        l_center[l_index] = (t_node_id)l_leaf;
+      }
+    return get_node(l_center[0],l_center[1],l_center[2],l_center[3]);
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::jump(const uint8_t & p_log_step)
+  {
+    // Board is centred in bigger empty nodes until result of outer node
+    // covers it and is high enough for the step, then board is extracted
+    t_node_id l_node = get_centered(m_root);
+    while(m_nodes[l_node].m_level < p_log_step + 2)
+      {
+        l_node = get_centered(l_node);
+      }
+    l_node = get_result(l_node,p_log_step);
+    while(m_nodes[l_node].m_level > m_root_level)
+      {
+        l_node = get_center(l_node);
+      }
+    return l_node;
+  }
+
+  //----------------------------------------------------------------------------
+  void hashlife_engine::set_root(const t_node_id & p_root)
+  {
+    m_root = p_root;
+    if(m_nodes.size() > m_collect_threshold)
+      {
+        collect();
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void hashlife_engine::collect(void)
+  {
+    std::vector<node> l_nodes(m_nodes.begin(),m_nodes.begin() + 4);
+    std::vector<t_node_id> l_new_ids(m_nodes.size(),0xFFFFFFFFU);
+    for(t_node_id l_id = 0 ; l_id < 4 ; ++l_id)
+      {
+        l_new_ids[l_id] = l_id;
+      }
+    m_root = copy(m_root,l_new_ids,l_nodes);
+    if(m_no_node != m_displayed_root)
+      {
+        m_displayed_root = copy(m_displayed_root,l_new_ids,l_nodes);
+      }
+    m_nodes.swap(l_nodes);
+    m_node_table.clear();
+    for(t_node_id l_id = 4 ; l_id < m_nodes.size() ; ++l_id)
+      {
+        const t_node_id * l_children = m_nodes[l_id].m_children;
+        m_node_table.insert(t_node_table::value_type(std::pair<uint64_t,uint64_t>((((uint64_t)l_children[0]) << 32) | l_children[1],(((uint64_t)l_children[2]) << 32) | l_children[3]),l_id));
+      }
+    m_results.clear();
+    m_empty.resize(1);
+    if(m_collect_threshold < 4 * m_nodes.size())
+      {
+        m_collect_threshold = 4 * m_nodes.size();
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_node_id hashlife_engine::copy(const t_node_id & p_node,
+                                                   std::vector<t_node_id> & p_new_ids,
+                                                   std::vector<node> & p_nodes)
+  {
+    if(0xFFFFFFFFU != p_new_ids[p_node])
+      {
+        return p_new_ids[p_node];
+      }
+    node l_node = m_nodes[p_node];
+    for(unsigned int l_index = 0 ; l_index < 4 ; ++l_index)
+      {
+        l_node.m_children[l_index] = copy(l_node.m_children[l_index],p_new_ids,p_nodes);
+      }
+    p_new_ids[p_node] = p_nodes.size();
+    p_nodes.push_back(l_node);
+    return p_new_ids[p_node];
+  }
+
+  //----------------------------------------------------------------------------
+  hashlife_engine::t_leaf hashlife_engine::get_leaf(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const
+  {
+    if((p_coordinates.first >> m_root_level) || (p_coordinates.second >> m_root_level))
+      {
+        return t_leaf::EMPTY;
+      }
+    t_node_id l_node = m_root;
+    for(uint8_t l_level = m_root_level ; l_level ; --l_level)
+      {
+        unsigned int l_quarter = ((p_coordinates.first >> (l_level - 1)) & 1) + 2 * ((p_coordinates.second >> (l_level - 1)) & 1);
+        l_node = m_nodes[l_node].m_children[l_quarter];
+      }
+    return (t_leaf)l_node;
+  }
+
+  //----------------------------------------------------------------------------
+  void hashlife_engine::display_changes(display_if & p_display,
+                                        const t_node_id & p_old,
+                                        const t_node_id & p_node,
+                                        const uint32_t & p_x,
+                                        const uint32_t & p_y)const
+  {
+    if(p_old == p_node)
+      {
+        return;
+      }
+    const node & l_node = m_nodes[p_node];
+    if(!l_node.m_level)
+      {
+        switch((t_leaf)p_node)
+          {
+          case t_leaf::COPPER:
+            p_display.display_cell(p_x,p_y,wireworld_common::wireworld_types::t_cell_state::COPPER);
+            break;
+          case t_leaf::ELECTRON:
+            p_display.display_cell(p_x,p_y,wireworld_common::wireworld_types::t_cell_state::ELECTRON);
+            break;
+          case t_leaf::TAIL:
+            p_display.display_cell(p_x,p_y,wireworld_common::wireworld_types::t_cell_state::TAIL);
+            break;
+          default:
+            break;
+          }
+        return;
+      }
+    if(!l_node.m_nb_cells)
+      {
+        return;
+      }
+    uint32_t l_half = ((uint32_t)1) << (l_node.m_level - 1);
+    for(unsigned int l_quarter = 0 ; l_quarter < 4 ; ++l_quarter)
+      {
+        t_node_id l_old = m_no_node;
+        if(m_no_node != p_old)
+          {
+            l_old = m_nodes[p_old].m_children[l_quarter];
+          }
+        display_changes(p_display,l_old,l_node.m_children[l_quarter],p_x + (l_quarter & 1) * l_half,p_y + (l_quarter >> 1) * l_half);
+      }
+  }
+}
+#endif // HASHLIFE_ENGINE_H
+//EOF
@@ -0,0 +1,99 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef PARALLEL_ENGINE_H
+#define PARALLEL_ENGINE_H
+
+#include "bitplane_engine.h"
+#include "work_stealing_pool.h"
+#include <vector>
+#include <iostream>
+
+namespace wireworld_systemc
+{
+  // Multi-threaded version of bitplane engine. Board is split in tiles made
+  // of full width bands of rows which are computed by a work stealing pool.
+  // Tiles only read current planes and write their own rows of next planes
+  // so there is no race at tile borders. Electrons are counted per tile and
+  // summed once all tiles are done
+  class parallel_engine: public bitplane_engine
+  {
+  public:
+    inline parallel_engine(const cell_index & p_index,
+                           const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                           const unsigned int & p_nb_threads);
+
+    // Method inherited from engine_if
+    inline void step(void);
+    // End of method inherited from engine_if
+  private:
+    inline void step_tile(const unsigned int & p_worker, const unsigned int & p_tile);
+
+    work_stealing_pool m_pool;
+    uint32_t m_tile_height;
+    unsigned int m_nb_tiles;
+    std::vector<uint32_t> m_tile_electrons;
+    work_stealing_pool::t_job m_job;
+  };
+
+  //----------------------------------------------------------------------------
+  parallel_engine::parallel_engine(const cell_index & p_index,
+                                   const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                   const unsigned int & p_nb_threads):
+    bitplane_engine(p_index,p_states),
+    m_pool(p_nb_threads),
+    m_tile_height(1),
+    m_nb_tiles(0)
+    {
+      // Around eight tiles per worker leave room for work stealing
+      uint32_t l_nb_rows = get_height() - 2;
+      uint32_t l_wanted_tiles = 8 * m_pool.get_nb_workers();
+      m_tile_height = l_nb_rows > l_wanted_tiles ? (l_nb_rows + l_wanted_tiles - 1) / l_wanted_tiles : 1;
+      m_nb_tiles = (l_nb_rows + m_tile_height - 1) / m_tile_height;
+      m_tile_electrons.resize(m_nb_tiles,0);
+      m_job = [this](const unsigned int & p_worker, const unsigned int & p_tile){this->step_tile(p_worker,p_tile);};
+      std::cout << "Parallel engine : " << m_pool.get_nb_workers() << " threads, " << m_nb_tiles << " tiles of " << m_tile_height << " rows" << std::endl ;
+    }
+
+  //----------------------------------------------------------------------------
+  void parallel_engine::step(void)
+  {
+    m_pool.run(m_job,m_nb_tiles);
+
+    uint32_t l_nb_electron = 0;
+    for(auto l_iter: m_tile_electrons)
+      {
+        l_nb_electron += l_iter;
+      }
+    end_step(l_nb_electron);
+  }
+
+  //----------------------------------------------------------------------------
+  void parallel_engine::step_tile(const unsigned int & p_worker, const unsigned int & p_tile)
+  {
+    uint32_t l_first_row = 1 + p_tile * m_tile_height;
+    uint32_t l_last_row = l_first_row + m_tile_height;
+    if(l_last_row > get_height() - 1)
+      {
+        l_last_row = get_height() - 1;
+      }
+    m_tile_electrons[p_tile] = step_rows(l_first_row,l_last_row);
+  }
+}
+#endif // PARALLEL_ENGINE_H
+//EOF
@@ -0,0 +1,450 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "systemc.h"
+#include "wireworld_types.h"
+#include "quicky_exception.h"
+#include "display_if.h"
+#include "cell_index.h"
+#include "period_detector.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+
+namespace wireworld_systemc
+{
+  // Block of cells evaluated by a single process. Cell states are stored in
+  // packed arrays and only cells read by another partition own a signal
+  class partition: public sc_module
+  {
+  public:
+    typedef unsigned int t_partition_id;
+    // Indexed by cell id
+    typedef std::vector<t_partition_id> t_partitionned_cells;
+    typedef std::vector<bool> t_exposed_cells;
+
+    SC_HAS_PROCESS(partition);
+    inline partition(sc_module_name p_name,
+                     const t_partition_id & p_id,
+                     const cell_index & p_index,
+                     const std::vector<cell_index::t_cell_id> & p_cells,
+                     const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                     const t_partitionned_cells & p_partitionned_cells,
+                     const std::vector<uint32_t> & p_local_indexes,
+                     const t_exposed_cells & p_exposed_cells,
+                     const bool & p_event_driven,
+                     const bool & p_active,
+                     display_if * p_display,
+                     unsigned int & p_nb_electron,
+                     uint64_t * p_hash);
+    inline ~partition(void);
+
+    // Group cells in square tiles of p_partition_size side. Partitions are
+    // numbered in order of their first cell
+    inline static void assign(const cell_index & p_index,
+                              const unsigned int & p_partition_size,
+                              t_partitionned_cells & p_partitionned_cells);
+
+    inline void bind_clk(sc_signal<bool> & p_clk);
+    inline unsigned int get_nb_inputs(void)const;
+    inline const cell_index::t_cell_id & get_input_id(const unsigned int & p_index)const;
+    inline void bind_input(sc_signal<bool> & p_signal, const unsigned int & p_index);
+    inline unsigned int get_nb_outputs(void)const;
+    inline cell_index::t_cell_id get_output_id(const unsigned int & p_index)const;
+    inline sc_signal<bool> & get_output(const unsigned int & p_index)const;
+    inline unsigned int get_nb_cells(void)const;
+    inline const wireworld_common::wireworld_types::t_coordinates & get_coordinates(const unsigned int & p_index)const;
+    inline const cell_index::t_cell_id & get_id(const unsigned int & p_index)const;
+    inline const wireworld_common::wireworld_types::t_cell_state & get_state(const unsigned int & p_index)const;
+    inline bool is_sleeping(void)const;
+
+    sc_in<bool> m_clk;
+
+    inline void run(void);
+  private:
+    inline void sleep(void);
+
+    const t_partition_id m_id;
+
+    // In event driven mode partition without electron or tail is removed from
+    // clock sensitivity until an electron arrives on one of its inputs
+    const bool m_event_driven;
+    bool m_sleeping;
+    sc_event_or_list m_wake_events;
+    bool m_wake_events_ready;
+    sc_event m_never;
+
+    // Cell states and ids, indexed by local cell index
+    const cell_index & m_index;
+    std::vector<wireworld_common::wireworld_types::t_cell_state> m_states;
+    std::vector<cell_index::t_cell_id> m_ids;
+
+    // Electron flags of current and next generation. Local cells come first
+    // then values sampled on input ports
+    std::vector<uint8_t> m_electrons;
+    std::vector<uint8_t> m_next_electrons;
+
+    // Neighbours of local cell i are m_neighbours[m_neighbour_offsets[i]] to
+    // m_neighbours[m_neighbour_offsets[i + 1] - 1], expressed as indexes in
+    // electron flags
+    std::vector<unsigned int> m_neighbour_offsets;
+    std::vector<unsigned int> m_neighbours;
+
+    std::vector<sc_in<bool>*> m_inputs;
+    std::vector<cell_index::t_cell_id> m_input_ids;
+
+    std::vector<std::pair<unsigned int,sc_signal<bool>*>> m_outputs;
+
+    display_if * m_display;
+    unsigned int & m_nb_electron;
+    // Board hash used by period detection, null when disabled
+    uint64_t * m_hash;
+  };
+
+  //----------------------------------------------------------------------------
+  partition::partition(sc_module_name p_name,
+                       const t_partition_id & p_id,
+                       const cell_index & p_index,
+                       const std::vector<cell_index::t_cell_id> & p_cells,
+                       const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                       const t_partitionned_cells & p_partitionned_cells,
+                       const std::vector<uint32_t> & p_local_indexes,
+                       const t_exposed_cells & p_exposed_cells,
+                       const bool & p_event_driven,
+                       const bool & p_active,
+                       display_if * p_display,
+                       unsigned int & p_nb_electron,
+                       uint64_t * p_hash):
+    sc_module(p_name),
+    m_clk("clk"),
+    m_id(p_id),
+    m_event_driven(p_event_driven),
+    m_sleeping(false),
+    m_wake_events_ready(false),
+    m_index(p_index),
+    m_ids(p_cells),
+    m_display(p_display),
+    m_nb_electron(p_nb_electron),
+    m_hash(p_hash)
+    {
+      unsigned int l_nb_cells = p_cells.size();
+
+      // Resolve neighbours either as local cells or as inputs
+      std::map<cell_index::t_cell_id,unsigned int> l_input_indexes;
+      m_neighbour_offsets.reserve(l_nb_cells + 1);
+      for(auto l_id: p_cells)
+        {
+          assert(m_id == p_partitionned_cells[l_id]);
+          m_neighbour_offsets.push_back(m_neighbours.size());
+          const cell_index::t_cell_id * l_neighbours = p_index.get_neighbours(l_id);
+          for(unsigned int l_neighbour_index = 0 ; l_neighbour_index < p_index.get_nb_neighbours(l_id) ; ++l_neighbour_index)
+            {
+              cell_index::t_cell_id l_neighbour_id = l_neighbours[l_neighbour_index];
+              if(m_id == p_partitionned_cells[l_neighbour_id])
+                {
+                  m_neighbours.push_back(p_local_indexes[l_neighbour_id]);
+                }
+              else
+                {
+                  std::map<cell_index::t_cell_id,unsigned int>::const_iterator l_input_iter = l_input_indexes.find(l_neighbour_id);
+                  if(l_input_indexes.end() == l_input_iter)
+                    {
+                      l_input_iter = l_input_indexes.insert(std::map<cell_index::t_cell_id,unsigned int>::value_type(l_neighbour_id,m_input_ids.size())).first;
+                      m_input_ids.push_back(l_neighbour_id);
+                    }
+                  m_neighbours.push_back(l_nb_cells + l_input_iter->second);
+                }
+            }
+        }
+      m_neighbour_offsets.push_back(m_neighbours.size());
+
+      // Create input ports
+      m_inputs.reserve(m_input_ids.size());
+      for(auto l_id: m_input_ids)
+        {
+          const wireworld_common::wireworld_types::t_coordinates & l_coordinates = p_index.get_coordinates(l_id);
+          std::stringstream l_stream;
+          l_stream << "from_" << l_coordinates.first << "_" << l_coordinates.second ;
+          m_inputs.push_back(new sc_in<bool>(l_stream.str().c_str()));
+        }
+
+      // Initialise states, electron flags and create signals of exposed cells
+      m_states.reserve(l_nb_cells);
+      m_electrons.resize(l_nb_cells + m_input_ids.size(),0);
+      for(unsigned int l_index = 0 ; l_index < l_nb_cells ; ++l_index)
+        {
+          const wireworld_common::wireworld_types::t_coordinates & l_coordinates = p_index.get_coordinates(p_cells[l_index]);
+          m_states.push_back(p_states[p_cells[l_index]]);
+          m_electrons[l_index] = wireworld_common::wireworld_types::t_cell_state::ELECTRON == m_states[l_index];
+          if(p_exposed_cells[p_cells[l_index]])
+            {
+              std::stringstream l_stream;
+              l_stream << l_coordinates.first << "_" << l_coordinates.second;
+              m_outputs.push_back(std::pair<unsigned int,sc_signal<bool>*>(l_index,new sc_signal<bool>(l_stream.str().c_str(),m_electrons[l_index])));
+            }
+#ifndef WIREWORLD_HEADLESS
+          if(m_display) m_display->display_cell(l_coordinates.first,l_coordinates.second,m_states[l_index]);
+#endif // WIREWORLD_HEADLESS
+        }
+      m_next_electrons = m_electrons;
+
+      SC_METHOD(run);
+      sensitive << m_clk.pos();
+      // An inactive partition is run once during initialisation: nothing
+      // changes as there is no electron around so it falls asleep at once
+      if(p_active || !m_event_driven)
+        {
+          dont_initialize();
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  partition::~partition(void)
+    {
+      for(auto l_iter: m_inputs)
+        {
+          delete l_iter;
+        }
+      for(auto l_iter: m_outputs)
+        {
+          delete l_iter.second;
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  void partition::assign(const cell_index & p_index,
+                         const unsigned int & p_partition_size,
+                         t_partitionned_cells & p_partitionned_cells)
+  {
+    std::map<std::pair<uint32_t,uint32_t>,t_partition_id> l_tiles;
+    p_partitionned_cells.resize(p_index.get_nb_cells());
+    for(cell_index::t_cell_id l_id = 0 ; l_id < p_index.get_nb_cells() ; ++l_id)
+      {
+        const wireworld_common::wireworld_types::t_coordinates & l_coordinates = p_index.get_coordinates(l_id);
+        std::pair<uint32_t,uint32_t> l_tile(l_coordinates.first / p_partition_size,l_coordinates.second / p_partition_size);
+        p_partitionned_cells[l_id] = l_tiles.insert(std::map<std::pair<uint32_t,uint32_t>,t_partition_id>::value_type(l_tile,l_tiles.size())).first->second;
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void partition::bind_clk(sc_signal<bool> & p_clk)
+  {
+    m_clk(p_clk);
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int partition::get_nb_inputs(void)const
+  {
+    return m_inputs.size();
+  }
+
+  //----------------------------------------------------------------------------
+  const cell_index::t_cell_id & partition::get_input_id(const unsigned int & p_index)const
+    {
+      assert(p_index < m_input_ids.size());
+      return m_input_ids[p_index];
+    }
+
+  //----------------------------------------------------------------------------
+  void partition::bind_input(sc_signal<bool> & p_signal, const unsigned int & p_index)
+  {
+    assert(p_index < m_inputs.size());
+    (*m_inputs[p_index])(p_signal);
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int partition::get_nb_outputs(void)const
+  {
+    return m_outputs.size();
+  }
+
+  //----------------------------------------------------------------------------
+  cell_index::t_cell_id partition::get_output_id(const unsigned int & p_index)const
+  {
+    assert(p_index < m_outputs.size());
+    return m_ids[m_outputs[p_index].first];
+  }
+
+  //----------------------------------------------------------------------------
+  sc_signal<bool> & partition::get_output(const unsigned int & p_index)const
+    {
+      assert(p_index < m_outputs.size());
+      return *(m_outputs[p_index].second);
+    }
+
+  //----------------------------------------------------------------------------
+  unsigned int partition::get_nb_cells(void)const
+  {
+    return m_states.size();
+  }
+
+  //----------------------------------------------------------------------------
+  const wireworld_common::wireworld_types::t_coordinates & partition::get_coordinates(const unsigned int & p_index)const
+    {
+      assert(p_index < m_ids.size());
+      return m_index.get_coordinates(m_ids[p_index]);
+    }
+
+  //----------------------------------------------------------------------------
+  const cell_index::t_cell_id & partition::get_id(const unsigned int & p_index)const
+    {
+      assert(p_index < m_ids.size());
+      return m_ids[p_index];
+    }
+
+  //----------------------------------------------------------------------------
+  const wireworld_common::wireworld_types::t_cell_state & partition::get_state(const unsigned int & p_index)const
+    {
+      assert(p_index < m_states.size());
+      return m_states[p_index];
+    }
+
+  //----------------------------------------------------------------------------
+  bool partition::is_sleeping(void)const
+  {
+    return m_sleeping;
+  }
+
+  //----------------------------------------------------------------------------
+  void partition::sleep(void)
+  {
+    if(!m_wake_events_ready)
+      {
+        for(auto l_iter: m_inputs)
+          {
+            m_wake_events |= l_iter->posedge_event();
+          }
+        m_wake_events_ready = true;
+      }
+    m_sleeping = true;
+    if(m_inputs.empty())
+      {
+        next_trigger(m_never);
+      }
+    else
+      {
+        next_trigger(m_wake_events);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void partition::run(void)
+  {
+    if(m_sleeping)
+      {
+        // Woken up by an electron arriving on an input. Cells will see it at
+        // next clock edge
+        m_sleeping = false;
+        next_trigger(m_clk.posedge_event());
+        return;
+      }
+
+    unsigned int l_nb_cells = m_states.size();
+    unsigned int l_nb_active = 0;
+
+    // Sample cells of neighbour partitions
+    for(unsigned int l_index = 0 ; l_index < m_inputs.size() ; ++l_index)
+      {
+        m_electrons[l_nb_cells + l_index] = m_inputs[l_index]->read();
+        l_nb_active += m_electrons[l_nb_cells + l_index];
+      }
+
+    for(unsigned int l_index = 0 ; l_index < l_nb_cells ; ++l_index)
+      {
+        switch(m_states[l_index])
+          {
+          case wireworld_common::wireworld_types::t_cell_state::COPPER:
+            {
+              unsigned int l_total = 0;
+              for(unsigned int l_neighbour_index = m_neighbour_offsets[l_index] ; l_neighbour_index < m_neighbour_offsets[l_index + 1] ; ++l_neighbour_index)
+                {
+                  l_total += m_electrons[m_neighbours[l_neighbour_index]];
+                }
+              if(l_total && l_total < 3)
+                {
+                  m_states[l_index] = wireworld_common::wireworld_types::t_cell_state::ELECTRON;
+                  if(m_hash) period_detector::update(*m_hash,get_coordinates(l_index).first,get_coordinates(l_index).second,wireworld_common::wireworld_types::t_cell_state::COPPER,m_states[l_index]);
+                  m_next_electrons[l_index] = 1;
+#ifndef WIREWORLD_HEADLESS
+                  if(m_display) m_display->display_cell(get_coordinates(l_index).first,get_coordinates(l_index).second,wireworld_common::wireworld_types::t_cell_state::ELECTRON);
+#endif // WIREWORLD_HEADLESS
+                  ++m_nb_electron;
+                  ++l_nb_active;
+#ifdef DEBUG_MESSAGES
+                  std::cout << "Cell(" << get_coordinates(l_index).first << "," << get_coordinates(l_index).second << ") switch to " << wireworld_common::wireworld_types::cell_state2string(m_states[l_index]) << " @" << sc_time_stamp() << std::endl ;
+#endif //DEBUG_MESSAGES
+                }
+            }
+            break;
+          case wireworld_common::wireworld_types::t_cell_state::TAIL:
+            m_states[l_index] = wireworld_common::wireworld_types::t_cell_state::COPPER;
+            if(m_hash) period_detector::update(*m_hash,get_coordinates(l_index).first,get_coordinates(l_index).second,wireworld_common::wireworld_types::t_cell_state::TAIL,m_states[l_index]);
+#ifndef WIREWORLD_HEADLESS
+            if(m_display) m_display->display_cell(get_coordinates(l_index).first,get_coordinates(l_index).second,wireworld_common::wireworld_types::t_cell_state::COPPER);
+#endif // WIREWORLD_HEADLESS
+#ifdef DEBUG_MESSAGES
+            std::cout << "Cell(" << get_coordinates(l_index).first << "," << get_coordinates(l_index).second << ") switch to " << wireworld_common::wireworld_types::cell_state2string(m_states[l_index]) << " @" << sc_time_stamp() << std::endl ;
+#endif // DEBUG_MESSAGES
+            break;
+          case wireworld_common::wireworld_types::t_cell_state::ELECTRON:
+            m_states[l_index] = wireworld_common::wireworld_types::t_cell_state::TAIL;
+            if(m_hash) period_detector::update(*m_hash,get_coordinates(l_index).first,get_coordinates(l_index).second,wireworld_common::wireworld_types::t_cell_state::ELECTRON,m_states[l_index]);
+            m_next_electrons[l_index] = 0;
+            ++l_nb_active;
+#ifndef WIREWORLD_HEADLESS
+            if(m_display) m_display->display_cell(get_coordinates(l_index).first,get_coordinates(l_index).second,wireworld_common::wireworld_types::t_cell_state::TAIL);
+#endif // WIREWORLD_HEADLESS
+#ifdef DEBUG_MESSAGES
+            std::cout << "Cell(" << get_coordinates(l_index).first << "," << get_coordinates(l_index).second << ") switch to " << wireworld_common::wireworld_types::cell_state2string(m_states[l_index]) << " @" << sc_time_stamp() << std::endl ;
+#endif // DEBUG_MESSAGES
+            break;
+          default:
+            {
+              std::stringstream l_stream;
+              l_stream << (unsigned int) m_states[l_index] ;
+              throw quicky_exception::quicky_logic_exception("Unknown state value : "+l_stream.str(),__LINE__,__FILE__);
+            }
+          }
+      }
+
+    // Drive signals of cells read by other partitions
+    for(auto l_iter: m_outputs)
+      {
+        if(m_electrons[l_iter.first] != m_next_electrons[l_iter.first])
+          {
+            l_iter.second->write(m_next_electrons[l_iter.first]);
+          }
+      }
+
+    // Next generation flags become current ones. Local part of next flags is
+    // refreshed from current ones as it is only written on transitions
+    m_electrons.swap(m_next_electrons);
+    std::copy(m_electrons.begin(),m_electrons.begin() + l_nb_cells,m_next_electrons.begin());
+
+    if(m_event_driven && !l_nb_active)
+      {
+        sleep();
+      }
+  }
+}
+#endif // PARTITION_H
+//EOF
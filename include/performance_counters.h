@@ -0,0 +1,319 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef PERFORMANCE_COUNTERS_H
+#define PERFORMANCE_COUNTERS_H
+
+#include "hardware_counters.h"
+#include "quicky_exception.h"
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // Simulation statistics sampled every p_interval generations in a CSV
+  // file, or in a JSON file if file name ends with ".json". A summary is
+  // added at the end of file and displayed when simulation ends. Time spent
+  // in kernel excludes elaboration and display, so do cache events counted by
+  // hardware counters. Unavailable events are left empty
+  class performance_counters
+  {
+  public:
+    typedef std::chrono::steady_clock t_clock;
+
+    inline performance_counters(const std::string & p_file_name,
+                                const unsigned int & p_interval);
+
+    inline void end_elaboration(void);
+    inline void start_gui(void);
+    inline void end_gui(void);
+
+    // Account p_nb_generations generations ending with p_generation whose
+    // computation updates p_nb_updates cells. p_nb_jumped_generations of
+    // them are computed at once without updating cells one by one. Activity
+    // is the one of first generation
+    inline void generation(const uint64_t & p_generation,
+                           const uint64_t & p_nb_generations,
+                           const uint64_t & p_nb_jumped_generations,
+                           const uint64_t & p_nb_updates,
+                           const uint64_t & p_nb_active_cells,
+                           const uint64_t & p_nb_active_partitions);
+
+    inline void summary(const uint64_t & p_generation);
+  private:
+    inline static bool is_json(const std::string & p_file_name);
+    inline static double get_duration(const t_clock::time_point & p_start,
+                                      const t_clock::time_point & p_end);
+    inline double get_kernel_duration(const t_clock::time_point & p_now)const;
+    // Write events counted since p_origin and update p_origin when not null
+    inline void write_events(uint64_t * p_origin);
+
+    std::ofstream m_file;
+    bool m_json;
+    unsigned int m_interval;
+    bool m_summary_done;
+
+    t_clock::time_point m_start;
+    t_clock::time_point m_kernel_start;
+    t_clock::time_point m_gui_start;
+    double m_elaboration_duration;
+    double m_gui_duration;
+
+    // Totals since kernel start
+    uint64_t m_nb_generations;
+    uint64_t m_nb_jumped_generations;
+    uint64_t m_nb_updates;
+
+    // Accumulated since last sample
+    t_clock::time_point m_sample_start;
+    double m_sample_gui_duration;
+    uint64_t m_sample_nb_generations;
+    uint64_t m_sample_nb_updates;
+    uint64_t m_sample_nb_active_cells;
+    uint64_t m_sample_nb_active_partitions;
+    bool m_first_sample;
+
+    hardware_counters m_hardware;
+    // Event counts at last sample
+    uint64_t m_sample_events[hardware_counters::m_nb_events];
+  };
+
+  //----------------------------------------------------------------------------
+  performance_counters::performance_counters(const std::string & p_file_name,
+                                             const unsigned int & p_interval):
+    m_file(p_file_name.c_str()),
+    m_json(is_json(p_file_name)),
+    m_interval(p_interval ? p_interval : 1),
+    m_summary_done(false),
+    m_start(t_clock::now()),
+    m_kernel_start(m_start),
+    m_gui_start(m_start),
+    m_elaboration_duration(0),
+    m_gui_duration(0),
+    m_nb_generations(0),
+    m_nb_jumped_generations(0),
+    m_nb_updates(0),
+    m_sample_start(m_start),
+    m_sample_gui_duration(0),
+    m_sample_nb_generations(0),
+    m_sample_nb_updates(0),
+    m_sample_nb_active_cells(0),
+    m_sample_nb_active_partitions(0),
+    m_first_sample(true)
+    {
+      for(unsigned int l_event = 0 ; l_event < hardware_counters::m_nb_events ; ++l_event)
+        {
+          m_sample_events[l_event] = 0;
+        }
+      if(!m_file.is_open())
+        {
+          throw quicky_exception::quicky_runtime_exception("Unable to create statistics file \"" + p_file_name + "\"",__LINE__,__FILE__);
+        }
+      if(m_json)
+        {
+          m_file << "{\"samples\":[" ;
+        }
+      else
+        {
+          m_file << "generation,kernel_seconds,generations_per_second,cell_updates_per_second,active_cells,active_partitions" ;
+          for(unsigned int l_event = 0 ; l_event < hardware_counters::m_nb_events ; ++l_event)
+            {
+              m_file << "," << hardware_counters::event2string((hardware_counters::t_event)l_event) ;
+            }
+          m_file << std::endl ;
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  void performance_counters::end_elaboration(void)
+  {
+    m_kernel_start = t_clock::now();
+    m_sample_start = m_kernel_start;
+    m_elaboration_duration = get_duration(m_start,m_kernel_start);
+    m_hardware.enable();
+  }
+
+  //----------------------------------------------------------------------------
+  void performance_counters::start_gui(void)
+  {
+    m_hardware.disable();
+    m_gui_start = t_clock::now();
+  }
+
+  //----------------------------------------------------------------------------
+  void performance_counters::end_gui(void)
+  {
+    double l_duration = get_duration(m_gui_start,t_clock::now());
+    m_gui_duration += l_duration;
+    m_sample_gui_duration += l_duration;
+    m_hardware.enable();
+  }
+
+  //----------------------------------------------------------------------------
+  void performance_counters::generation(const uint64_t & p_generation,
+                                        const uint64_t & p_nb_generations,
+                                        const uint64_t & p_nb_jumped_generations,
+                                        const uint64_t & p_nb_updates,
+                                        const uint64_t & p_nb_active_cells,
+                                        const uint64_t & p_nb_active_partitions)
+  {
+    m_nb_generations += p_nb_generations;
+    m_nb_jumped_generations += p_nb_jumped_generations;
+    m_nb_updates += p_nb_updates;
+    m_sample_nb_generations += p_nb_generations;
+    m_sample_nb_updates += p_nb_updates;
+    m_sample_nb_active_cells += p_nb_active_cells * p_nb_generations;
+    m_sample_nb_active_partitions += p_nb_active_partitions * p_nb_generations;
+    // Sample when an interval boundary is reached
+    if(p_generation / m_interval == (p_generation - p_nb_generations) / m_interval)
+      {
+        return;
+      }
+    t_clock::time_point l_now = t_clock::now();
+    double l_duration = get_duration(m_sample_start,l_now) - m_sample_gui_duration;
+    double l_generation_rate = l_duration > 0 ? m_sample_nb_generations / l_duration : 0;
+    double l_update_rate = l_duration > 0 ? m_sample_nb_updates / l_duration : 0;
+    // Activity is averaged over generations of sample
+    double l_active_cells = ((double)m_sample_nb_active_cells) / m_sample_nb_generations;
+    double l_active_partitions = ((double)m_sample_nb_active_partitions) / m_sample_nb_generations;
+    if(m_json)
+      {
+        m_file << (m_first_sample ? "" : ",") << std::endl;
+        m_file << "{\"generation\":" << p_generation << ",\"kernel_seconds\":" << get_kernel_duration(l_now) << ",\"generations_per_second\":" << l_generation_rate << ",\"cell_updates_per_second\":" << l_update_rate << ",\"active_cells\":" << l_active_cells << ",\"active_partitions\":" << l_active_partitions ;
+        write_events(m_sample_events);
+        m_file << "}" ;
+      }
+    else
+      {
+        m_file << p_generation << "," << get_kernel_duration(l_now) << "," << l_generation_rate << "," << l_update_rate << "," << l_active_cells << "," << l_active_partitions ;
+        write_events(m_sample_events);
+        m_file << std::endl ;
+      }
+    m_first_sample = false;
+    m_sample_start = l_now;
+    m_sample_gui_duration = 0;
+    m_sample_nb_generations = 0;
+    m_sample_nb_updates = 0;
+    m_sample_nb_active_cells = 0;
+    m_sample_nb_active_partitions = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  void performance_counters::summary(const uint64_t & p_generation)
+  {
+    if(m_summary_done)
+      {
+        return;
+      }
+    m_summary_done = true;
+    m_hardware.disable();
+    double l_kernel_duration = get_kernel_duration(t_clock::now());
+    double l_generation_rate = l_kernel_duration > 0 ? m_nb_generations / l_kernel_duration : 0;
+    double l_update_rate = l_kernel_duration > 0 ? m_nb_updates / l_kernel_duration : 0;
+    std::cout << "Generations : " << m_nb_generations << " (" << l_generation_rate << "/s)" << std::endl ;
+    std::cout << "Cell updates : " << m_nb_updates << " (" << l_update_rate << "/s)" << std::endl ;
+    if(m_nb_jumped_generations)
+      {
+        std::cout << "Jumped generations : " << m_nb_jumped_generations << " (not counted in cell updates)" << std::endl ;
+      }
+    std::cout << "Elaboration : " << m_elaboration_duration << "s, kernel : " << l_kernel_duration << "s, GUI : " << m_gui_duration << "s" << std::endl ;
+    uint64_t l_nb_references = 0;
+    uint64_t l_nb_misses = 0;
+    if(m_hardware.get(hardware_counters::t_event::CACHE_REFERENCES,l_nb_references) && m_hardware.get(hardware_counters::t_event::CACHE_MISSES,l_nb_misses))
+      {
+        std::cout << "Cache misses : " << l_nb_misses << " of " << l_nb_references << " references" << std::endl ;
+      }
+    if(m_json)
+      {
+        m_file << std::endl << "],\"summary\":{\"generation\":" << p_generation << ",\"generations\":" << m_nb_generations << ",\"jumped_generations\":" << m_nb_jumped_generations << ",\"cell_updates\":" << m_nb_updates << ",\"generations_per_second\":" << l_generation_rate << ",\"cell_updates_per_second\":" << l_update_rate << ",\"elaboration_seconds\":" << m_elaboration_duration << ",\"kernel_seconds\":" << l_kernel_duration << ",\"gui_seconds\":" << m_gui_duration ;
+        write_events(nullptr);
+        m_file << "}}" << std::endl ;
+      }
+    else
+      {
+        m_file << "# generation,generations,jumped_generations,cell_updates,generations_per_second,cell_updates_per_second,elaboration_seconds,kernel_seconds,gui_seconds" ;
+        for(unsigned int l_event = 0 ; l_event < hardware_counters::m_nb_events ; ++l_event)
+          {
+            m_file << "," << hardware_counters::event2string((hardware_counters::t_event)l_event) ;
+          }
+        m_file << std::endl ;
+        m_file << "# " << p_generation << "," << m_nb_generations << "," << m_nb_jumped_generations << "," << m_nb_updates << "," << l_generation_rate << "," << l_update_rate << "," << m_elaboration_duration << "," << l_kernel_duration << "," << m_gui_duration ;
+        write_events(nullptr);
+        m_file << std::endl ;
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void performance_counters::write_events(uint64_t * p_origin)
+  {
+    for(unsigned int l_event = 0 ; l_event < hardware_counters::m_nb_events ; ++l_event)
+      {
+        uint64_t l_value = 0;
+        bool l_available = m_hardware.get((hardware_counters::t_event)l_event,l_value);
+        uint64_t l_count = l_value - (p_origin ? p_origin[l_event] : 0);
+        if(m_json)
+          {
+            m_file << ",\"" << hardware_counters::event2string((hardware_counters::t_event)l_event) << "\":" ;
+            if(l_available)
+              {
+                m_file << l_count ;
+              }
+            else
+              {
+                m_file << "null" ;
+              }
+          }
+        else
+          {
+            m_file << "," ;
+            if(l_available)
+              {
+                m_file << l_count ;
+              }
+          }
+        if(p_origin)
+          {
+            p_origin[l_event] = l_value;
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  bool performance_counters::is_json(const std::string & p_file_name)
+  {
+    return p_file_name.size() > 5 && ".json" == p_file_name.substr(p_file_name.size() - 5);
+  }
+
+  //----------------------------------------------------------------------------
+  double performance_counters::get_duration(const t_clock::time_point & p_start,
+                                            const t_clock::time_point & p_end)
+  {
+    return std::chrono::duration<double>(p_end - p_start).count();
+  }
+
+  //----------------------------------------------------------------------------
+  double performance_counters::get_kernel_duration(const t_clock::time_point & p_now)const
+  {
+    return get_duration(m_kernel_start,p_now) - m_gui_duration;
+  }
+}
+#endif // PERFORMANCE_COUNTERS_H
+//EOF
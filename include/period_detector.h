@@ -0,0 +1,143 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef PERIOD_DETECTOR_H
+#define PERIOD_DETECTOR_H
+
+#include "wireworld_types.h"
+#include <vector>
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // Detect that board came back to a previous state. Board is summarised by
+  // a Zobrist hash: xor of a pseudo random key per electron and per tail,
+  // copper having a null key, that cells update on each transition.
+  // Reference state is moved to current generation after 1, 2, 4 ...
+  // generations (Brent's algorithm) so memory does not depend on period
+  // length. A hash match is confirmed by comparing full states
+  class period_detector
+  {
+  public:
+    inline period_detector(void);
+
+    inline static uint64_t get_key(const uint32_t & p_x,
+                                   const uint32_t & p_y,
+                                   const wireworld_common::wireworld_types::t_cell_state & p_state);
+
+    // Update hash of a cell going from state p_old to state p_new
+    inline static void update(uint64_t & p_hash,
+                              const uint32_t & p_x,
+                              const uint32_t & p_y,
+                              const wireworld_common::wireworld_types::t_cell_state & p_old,
+                              const wireworld_common::wireworld_types::t_cell_state & p_new);
+
+    // Tell if states are worth being given to check for this hash
+    inline bool need_states(const uint64_t & p_generation,
+                            const uint64_t & p_hash)const;
+    // Return true when board at p_generation is known to be the same as
+    // p_period generations before
+    inline bool check(const uint64_t & p_generation,
+                      const uint64_t & p_hash,
+                      const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states);
+    inline const uint64_t & get_period(void)const;
+  private:
+    uint64_t m_reference_generation;
+    uint64_t m_reference_hash;
+    std::vector<wireworld_common::wireworld_types::t_cell_state> m_reference_states;
+    uint64_t m_power;
+    bool m_started;
+    uint64_t m_period;
+  };
+
+  //----------------------------------------------------------------------------
+  period_detector::period_detector(void):
+    m_reference_generation(0),
+    m_reference_hash(0),
+    m_power(1),
+    m_started(false),
+    m_period(0)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  uint64_t period_detector::get_key(const uint32_t & p_x,
+                                    const uint32_t & p_y,
+                                    const wireworld_common::wireworld_types::t_cell_state & p_state)
+  {
+    if(wireworld_common::wireworld_types::t_cell_state::COPPER == p_state)
+      {
+        return 0;
+      }
+    // splitmix64 finaliser of position and state
+    uint64_t l_key = ((((uint64_t)p_x) << 32) | p_y) * 2 + (wireworld_common::wireworld_types::t_cell_state::TAIL == p_state);
+    l_key += 0x9E3779B97F4A7C15ULL;
+    l_key = (l_key ^ (l_key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    l_key = (l_key ^ (l_key >> 27)) * 0x94D049BB133111EBULL;
+    return l_key ^ (l_key >> 31);
+  }
+
+  //----------------------------------------------------------------------------
+  void period_detector::update(uint64_t & p_hash,
+                               const uint32_t & p_x,
+                               const uint32_t & p_y,
+                               const wireworld_common::wireworld_types::t_cell_state & p_old,
+                               const wireworld_common::wireworld_types::t_cell_state & p_new)
+  {
+    p_hash ^= get_key(p_x,p_y,p_old) ^ get_key(p_x,p_y,p_new);
+  }
+
+  //----------------------------------------------------------------------------
+  bool period_detector::need_states(const uint64_t & p_generation,
+                                    const uint64_t & p_hash)const
+  {
+    return !m_started || p_hash == m_reference_hash || p_generation - m_reference_generation == m_power;
+  }
+
+  //----------------------------------------------------------------------------
+  bool period_detector::check(const uint64_t & p_generation,
+                              const uint64_t & p_hash,
+                              const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)
+  {
+    if(m_started && p_hash == m_reference_hash && p_states == m_reference_states)
+      {
+        m_period = p_generation - m_reference_generation;
+        return true;
+      }
+    if(!m_started || p_generation - m_reference_generation == m_power)
+      {
+        if(m_started)
+          {
+            m_power *= 2;
+          }
+        m_started = true;
+        m_reference_generation = p_generation;
+        m_reference_hash = p_hash;
+        m_reference_states = p_states;
+      }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  const uint64_t & period_detector::get_period(void)const
+    {
+      return m_period;
+    }
+}
+#endif // PERIOD_DETECTOR_H
+//EOF
@@ -0,0 +1,216 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef PROBE_SET_H
+#define PROBE_SET_H
+
+#include "cell_index.h"
+#include "quicky_exception.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+
+namespace wireworld_systemc
+{
+  // Cells whose state is recorded every generation. Probes are read from a
+  // file where each line is "[name] X,Y [stop:e|stop:t|stop:c]", name
+  // defaulting to "X_Y". Simulation stops at first generation where a probe
+  // having a stop condition is electron, tail or copper. Empty lines and
+  // lines starting with '#' are ignored.
+  // States are stored as runs of identical states so that memory depends on
+  // activity of probed cells only, they are written in CSV at end of
+  // simulation: one line per run with probe name, coordinates, first
+  // generation, number of generations and state
+  class probe_set
+  {
+  public:
+    inline probe_set(const std::string & p_file_name,
+                     const cell_index & p_index);
+    inline unsigned int get_nb_probes(void)const;
+    inline const cell_index::t_cell_id & get_id(const unsigned int & p_probe)const;
+    inline bool is_probed(const cell_index::t_cell_id & p_id)const;
+    // Generations of a probe have to be recorded in increasing order.
+    // Return true if stop condition of probe is met
+    inline bool record(const unsigned int & p_probe,
+                       const uint64_t & p_generation,
+                       const wireworld_common::wireworld_types::t_cell_state & p_state);
+    // Report probe whose stop condition is met at p_generation
+    inline void report_stop(const unsigned int & p_probe,
+                            const uint64_t & p_generation)const;
+    // p_generation is last simulated generation
+    inline void save(const std::string & p_file_name,
+                     const uint64_t & p_generation)const;
+  private:
+    typedef struct
+    {
+      std::string m_name;
+      cell_index::t_cell_id m_id;
+      bool m_stop;
+      wireworld_common::wireworld_types::t_cell_state m_stop_state;
+      // First generation and state of each run
+      std::vector<std::pair<uint64_t,wireworld_common::wireworld_types::t_cell_state>> m_runs;
+    } t_probe;
+
+    inline void parse(const std::string & p_line,
+                      const unsigned int & p_line_number);
+
+    const cell_index & m_index;
+    std::vector<t_probe> m_probes;
+    // Sorted ids of probed cells
+    std::vector<cell_index::t_cell_id> m_ids;
+  };
+
+  //----------------------------------------------------------------------------
+  probe_set::probe_set(const std::string & p_file_name,
+                       const cell_index & p_index):
+    m_index(p_index)
+    {
+      std::ifstream l_file(p_file_name.c_str());
+      if(!l_file.is_open())
+        {
+          throw quicky_exception::quicky_runtime_exception("Unable to open probe file \"" + p_file_name + "\"",__LINE__,__FILE__);
+        }
+      std::string l_line;
+      unsigned int l_line_number = 0;
+      while(std::getline(l_file,l_line))
+        {
+          ++l_line_number;
+          if(l_line.find_first_not_of(" \t\r") == std::string::npos || '#' == l_line[l_line.find_first_not_of(" \t\r")])
+            {
+              continue;
+            }
+          parse(l_line,l_line_number);
+        }
+      if(m_probes.empty())
+        {
+          throw quicky_exception::quicky_runtime_exception("No probe defined in probe file \"" + p_file_name + "\"",__LINE__,__FILE__);
+        }
+      for(auto & l_probe: m_probes)
+        {
+          m_ids.push_back(l_probe.m_id);
+        }
+      std::sort(m_ids.begin(),m_ids.end());
+    }
+
+  //----------------------------------------------------------------------------
+  void probe_set::parse(const std::string & p_line,
+                        const unsigned int & p_line_number)
+  {
+    std::stringstream l_line_stream;
+    l_line_stream << p_line_number;
+    std::stringstream l_stream(p_line);
+    std::vector<std::string> l_items;
+    std::string l_item;
+    while(l_stream >> l_item)
+      {
+        l_items.push_back(l_item);
+      }
+    // Name is optional
+    unsigned int l_index = std::string::npos == l_items[0].find(',') ? 1 : 0;
+    uint32_t l_x = 0;
+    uint32_t l_y = 0;
+    char l_end = 0;
+    t_probe l_probe;
+    l_probe.m_stop = false;
+    l_probe.m_stop_state = wireworld_common::wireworld_types::t_cell_state::ELECTRON;
+    if(l_index >= l_items.size() || 2 != sscanf(l_items[l_index].c_str(),"%u,%u%c",&l_x,&l_y,&l_end) || !m_index.find(wireworld_common::wireworld_types::t_coordinates(l_x,l_y),l_probe.m_id))
+      {
+        throw quicky_exception::quicky_runtime_exception("Bad probe at line " + l_line_stream.str() + " of probe file: expecting [name] X,Y with (X,Y) a copper cell",__LINE__,__FILE__);
+      }
+    l_probe.m_name = l_index ? l_items[0] : std::to_string(l_x) + "_" + std::to_string(l_y);
+    for(++l_index ; l_index < l_items.size() ; ++l_index)
+      {
+        if("stop:e" == l_items[l_index] || "stop:t" == l_items[l_index] || "stop:c" == l_items[l_index])
+          {
+            l_probe.m_stop = true;
+            char l_state = l_items[l_index][5];
+            l_probe.m_stop_state = 'e' == l_state ? wireworld_common::wireworld_types::t_cell_state::ELECTRON : ('t' == l_state ? wireworld_common::wireworld_types::t_cell_state::TAIL : wireworld_common::wireworld_types::t_cell_state::COPPER);
+          }
+        else
+          {
+            throw quicky_exception::quicky_runtime_exception("Bad stop condition \"" + l_items[l_index] + "\" at line " + l_line_stream.str() + " of probe file: expecting stop:e, stop:t or stop:c",__LINE__,__FILE__);
+          }
+      }
+    m_probes.push_back(l_probe);
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int probe_set::get_nb_probes(void)const
+  {
+    return m_probes.size();
+  }
+
+  //----------------------------------------------------------------------------
+  const cell_index::t_cell_id & probe_set::get_id(const unsigned int & p_probe)const
+    {
+      return m_probes[p_probe].m_id;
+    }
+
+  //----------------------------------------------------------------------------
+  bool probe_set::is_probed(const cell_index::t_cell_id & p_id)const
+  {
+    return std::binary_search(m_ids.begin(),m_ids.end(),p_id);
+  }
+
+  //----------------------------------------------------------------------------
+  bool probe_set::record(const unsigned int & p_probe,
+                         const uint64_t & p_generation,
+                         const wireworld_common::wireworld_types::t_cell_state & p_state)
+  {
+    t_probe & l_probe = m_probes[p_probe];
+    if(l_probe.m_runs.empty() || l_probe.m_runs.back().second != p_state)
+      {
+        l_probe.m_runs.push_back(std::pair<uint64_t,wireworld_common::wireworld_types::t_cell_state>(p_generation,p_state));
+      }
+    return l_probe.m_stop && l_probe.m_stop_state == p_state;
+  }
+
+  //----------------------------------------------------------------------------
+  void probe_set::report_stop(const unsigned int & p_probe,
+                              const uint64_t & p_generation)const
+  {
+    std::cout << "Generation " << p_generation << " : probe " << m_probes[p_probe].m_name << " is " << wireworld_common::wireworld_types::cell_state2string(m_probes[p_probe].m_stop_state) << ", simulation stopped" << std::endl ;
+  }
+
+  //----------------------------------------------------------------------------
+  void probe_set::save(const std::string & p_file_name,
+                       const uint64_t & p_generation)const
+  {
+    std::ofstream l_file(p_file_name.c_str());
+    if(!l_file.is_open())
+      {
+        throw quicky_exception::quicky_runtime_exception("Unable to create probe output file \"" + p_file_name + "\"",__LINE__,__FILE__);
+      }
+    l_file << "probe,x,y,generation,length,state" << std::endl ;
+    for(auto & l_probe: m_probes)
+      {
+        const wireworld_common::wireworld_types::t_coordinates & l_coordinates = m_index.get_coordinates(l_probe.m_id);
+        for(unsigned int l_run = 0 ; l_run < l_probe.m_runs.size() ; ++l_run)
+          {
+            uint64_t l_end = l_run + 1 < l_probe.m_runs.size() ? l_probe.m_runs[l_run + 1].first : p_generation + 1;
+            l_file << l_probe.m_name << "," << l_coordinates.first << "," << l_coordinates.second << "," << l_probe.m_runs[l_run].first << "," << l_end - l_probe.m_runs[l_run].first << "," << wireworld_common::wireworld_types::cell_state2string(l_probe.m_runs[l_run].second) << std::endl ;
+          }
+      }
+  }
+}
+#endif // PROBE_SET_H
+//EOF
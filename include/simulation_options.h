@@ -0,0 +1,569 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef SIMULATION_OPTIONS_H
+#define SIMULATION_OPTIONS_H
+
+#include "cell_index.h"
+#include "quicky_exception.h"
+#include <string>
+#include <cstdlib>
+#include <thread>
+
+namespace wireworld_systemc
+{
+  // Options specific to wireworld_systemc. They are removed from command line
+  // before it is given to wireworld_prepare
+  class simulation_options
+  {
+  public:
+    typedef enum class engine {CELL, PARTITION, BITPLANE, PARALLEL, HASHLIFE, BAND} t_engine;
+
+    inline simulation_options(void);
+    inline void extract(int & p_argc, char ** p_argv);
+
+    inline const t_engine & get_engine(void)const;
+    inline const unsigned int & get_partition_size(void)const;
+    inline const bool & is_event_driven(void)const;
+    inline bool is_systemc_engine(void)const;
+    inline const bool & is_check(void)const;
+    inline const t_engine & get_check_engine(void)const;
+    inline const unsigned int & get_nb_threads(void)const;
+    inline const unsigned int & get_band_height(void)const;
+    inline const std::string & get_band_directory(void)const;
+    inline const cell_index::t_order & get_cell_order(void)const;
+    inline const bool & is_compact_names(void)const;
+    inline const bool & is_delay_lines(void)const;
+    inline const std::string & get_checkpoint_file(void)const;
+    inline const unsigned int & get_checkpoint_interval(void)const;
+    inline bool is_restore(void)const;
+    inline const std::string & get_restore_file(void)const;
+    inline bool is_compile(void)const;
+    inline bool is_batch(void)const;
+    inline const std::string & get_batch_file(void)const;
+    inline const unsigned int & get_batch_lanes(void)const;
+    inline bool is_probe(void)const;
+    inline const std::string & get_probe_file(void)const;
+    inline const std::string & get_probe_output_file(void)const;
+    inline const std::string & get_compile_file(void)const;
+    inline const bool & is_detect_period(void)const;
+    inline const bool & is_headless(void)const;
+    inline const bool & is_async_display(void)const;
+    inline const std::string & get_trace_file(void)const;
+    inline const std::string & get_stats_file(void)const;
+    inline const unsigned int & get_stats_interval(void)const;
+
+    inline static std::string engine2string(const t_engine & p_engine);
+  private:
+    inline static t_engine string2engine(const std::string & p_name);
+
+    inline static bool get_value(const std::string & p_arg,
+                                 const std::string & p_name,
+                                 std::string & p_value);
+    inline static unsigned int to_unsigned(const std::string & p_name,
+                                           const std::string & p_value);
+
+    t_engine m_engine;
+    unsigned int m_partition_size;
+    bool m_event_driven;
+    bool m_check;
+    t_engine m_check_engine;
+    unsigned int m_nb_threads;
+    unsigned int m_band_height;
+    std::string m_band_directory;
+    cell_index::t_order m_cell_order;
+    bool m_compact_names;
+    bool m_delay_lines;
+    std::string m_checkpoint_file;
+    unsigned int m_checkpoint_interval;
+    std::string m_restore_file;
+    std::string m_compile_file;
+    std::string m_batch_file;
+    unsigned int m_batch_lanes;
+    std::string m_probe_file;
+    std::string m_probe_output_file;
+    bool m_detect_period;
+    bool m_headless;
+    bool m_async_display;
+    std::string m_trace_file;
+    std::string m_stats_file;
+    unsigned int m_stats_interval;
+  };
+
+  //----------------------------------------------------------------------------
+  simulation_options::simulation_options(void):
+    m_engine(t_engine::CELL),
+    m_partition_size(64),
+    m_event_driven(false),
+    m_check(false),
+    m_check_engine(t_engine::BITPLANE),
+    m_nb_threads(std::thread::hardware_concurrency()),
+    m_band_height(64),
+    m_band_directory("."),
+    m_cell_order(cell_index::t_order::ROW_MAJOR),
+    m_compact_names(false),
+    m_delay_lines(false),
+    m_checkpoint_interval(0),
+    m_batch_lanes(0),
+    m_detect_period(false),
+#ifdef WIREWORLD_HEADLESS
+    m_headless(true),
+#else
+    m_headless(false),
+#endif // WIREWORLD_HEADLESS
+    m_async_display(false),
+    m_trace_file("trace.vcd"),
+    m_stats_interval(0)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  void simulation_options::extract(int & p_argc, char ** p_argv)
+  {
+    int l_kept = 1;
+    for(int l_index = 1 ; l_index < p_argc ; ++l_index)
+      {
+        std::string l_arg(p_argv[l_index]);
+        std::string l_value;
+        if(get_value(l_arg,"engine",l_value))
+          {
+            m_engine = string2engine(l_value);
+          }
+        else if(get_value(l_arg,"check",l_value))
+          {
+            m_check = true;
+            m_check_engine = string2engine(l_value);
+          }
+        else if(get_value(l_arg,"partition_size",l_value))
+          {
+            m_partition_size = to_unsigned("partition_size",l_value);
+            if(!m_partition_size)
+              {
+                throw quicky_exception::quicky_runtime_exception("Partition size should be strictly positive",__LINE__,__FILE__);
+              }
+          }
+        else if(get_value(l_arg,"threads",l_value))
+          {
+            m_nb_threads = to_unsigned("threads",l_value);
+          }
+        else if(get_value(l_arg,"band_height",l_value))
+          {
+            m_band_height = to_unsigned("band_height",l_value);
+            if(!m_band_height)
+              {
+                throw quicky_exception::quicky_runtime_exception("Band height should be strictly positive",__LINE__,__FILE__);
+              }
+          }
+        else if(get_value(l_arg,"band_dir",l_value))
+          {
+            m_band_directory = l_value;
+          }
+        else if(get_value(l_arg,"cell_order",l_value))
+          {
+            m_cell_order = cell_index::string2order(l_value);
+          }
+        else if("--event_driven" == l_arg)
+          {
+            m_event_driven = true;
+          }
+        else if(get_value(l_arg,"checkpoint",l_value))
+          {
+            m_checkpoint_file = l_value;
+          }
+        else if(get_value(l_arg,"checkpoint_interval",l_value))
+          {
+            m_checkpoint_interval = to_unsigned("checkpoint_interval",l_value);
+          }
+        else if(get_value(l_arg,"trace_file",l_value))
+          {
+            m_trace_file = l_value;
+          }
+        else if(get_value(l_arg,"stats",l_value))
+          {
+            m_stats_file = l_value;
+          }
+        else if(get_value(l_arg,"stats_interval",l_value))
+          {
+            m_stats_interval = to_unsigned("stats_interval",l_value);
+          }
+        else if(get_value(l_arg,"restore",l_value))
+          {
+            m_restore_file = l_value;
+          }
+        else if(get_value(l_arg,"compile",l_value))
+          {
+            m_compile_file = l_value;
+          }
+        else if(get_value(l_arg,"batch",l_value))
+          {
+            m_batch_file = l_value;
+          }
+        else if(get_value(l_arg,"batch_lanes",l_value))
+          {
+            m_batch_lanes = to_unsigned("batch_lanes",l_value);
+          }
+        else if(get_value(l_arg,"probes",l_value))
+          {
+            m_probe_file = l_value;
+          }
+        else if(get_value(l_arg,"probe_output",l_value))
+          {
+            m_probe_output_file = l_value;
+          }
+        else if("--compact_names" == l_arg)
+          {
+            m_compact_names = true;
+          }
+        else if("--delay_lines" == l_arg)
+          {
+            m_delay_lines = true;
+          }
+        else if("--detect_period" == l_arg)
+          {
+            m_detect_period = true;
+          }
+        else if("--headless" == l_arg)
+          {
+            m_headless = true;
+          }
+        else if("--async_display" == l_arg)
+          {
+            m_async_display = true;
+          }
+        else
+          {
+            p_argv[l_kept] = p_argv[l_index];
+            ++l_kept;
+          }
+      }
+    p_argc = l_kept;
+    p_argv[p_argc] = nullptr;
+
+    if(m_check && (!is_systemc_engine() || t_engine::CELL == m_check_engine || t_engine::PARTITION == m_check_engine))
+      {
+        throw quicky_exception::quicky_runtime_exception("Check compares a SystemC engine with an engine that does not rely on SystemC",__LINE__,__FILE__);
+      }
+    if(m_checkpoint_interval && m_checkpoint_file.empty())
+      {
+        throw quicky_exception::quicky_runtime_exception("Checkpoint interval requires a checkpoint file",__LINE__,__FILE__);
+      }
+    if(m_stats_interval && m_stats_file.empty())
+      {
+        throw quicky_exception::quicky_runtime_exception("Statistics interval requires a statistics file",__LINE__,__FILE__);
+      }
+    if(!m_stats_interval)
+      {
+        m_stats_interval = 100;
+      }
+    if(m_detect_period && !is_systemc_engine())
+      {
+        throw quicky_exception::quicky_runtime_exception("Period detection is only available with SystemC engines",__LINE__,__FILE__);
+      }
+    if(m_batch_lanes && m_batch_file.empty())
+      {
+        throw quicky_exception::quicky_runtime_exception("Batch lanes require a batch file",__LINE__,__FILE__);
+      }
+    if(!m_batch_lanes)
+      {
+        m_batch_lanes = 256;
+      }
+    if(!m_probe_output_file.empty() && m_probe_file.empty())
+      {
+        throw quicky_exception::quicky_runtime_exception("Probe output requires a probe file",__LINE__,__FILE__);
+      }
+    if(m_probe_output_file.empty())
+      {
+        m_probe_output_file = "probes.csv";
+      }
+    if(is_probe() && is_batch())
+      {
+        throw quicky_exception::quicky_runtime_exception("Probes are not available in batch mode",__LINE__,__FILE__);
+      }
+    if(m_delay_lines && t_engine::CELL != m_engine)
+      {
+        throw quicky_exception::quicky_runtime_exception("Delay lines are only available with cell engine",__LINE__,__FILE__);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  const simulation_options::t_engine & simulation_options::get_engine(void)const
+    {
+      return m_engine;
+    }
+
+  //----------------------------------------------------------------------------
+  const unsigned int & simulation_options::get_partition_size(void)const
+    {
+      return m_partition_size;
+    }
+
+  //----------------------------------------------------------------------------
+  const bool & simulation_options::is_event_driven(void)const
+    {
+      return m_event_driven;
+    }
+
+  //----------------------------------------------------------------------------
+  bool simulation_options::is_systemc_engine(void)const
+  {
+    return t_engine::CELL == m_engine || t_engine::PARTITION == m_engine;
+  }
+
+  //----------------------------------------------------------------------------
+  const bool & simulation_options::is_check(void)const
+    {
+      return m_check;
+    }
+
+  //----------------------------------------------------------------------------
+  const simulation_options::t_engine & simulation_options::get_check_engine(void)const
+    {
+      return m_check_engine;
+    }
+
+  //----------------------------------------------------------------------------
+  const unsigned int & simulation_options::get_nb_threads(void)const
+    {
+      return m_nb_threads;
+    }
+
+  //----------------------------------------------------------------------------
+  const unsigned int & simulation_options::get_band_height(void)const
+    {
+      return m_band_height;
+    }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_band_directory(void)const
+    {
+      return m_band_directory;
+    }
+
+  //----------------------------------------------------------------------------
+  const cell_index::t_order & simulation_options::get_cell_order(void)const
+    {
+      return m_cell_order;
+    }
+
+  //----------------------------------------------------------------------------
+  const bool & simulation_options::is_compact_names(void)const
+    {
+      return m_compact_names;
+    }
+
+  //----------------------------------------------------------------------------
+  const bool & simulation_options::is_delay_lines(void)const
+    {
+      return m_delay_lines;
+    }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_checkpoint_file(void)const
+    {
+      return m_checkpoint_file;
+    }
+
+  //----------------------------------------------------------------------------
+  const unsigned int & simulation_options::get_checkpoint_interval(void)const
+    {
+      return m_checkpoint_interval;
+    }
+
+  //----------------------------------------------------------------------------
+  bool simulation_options::is_restore(void)const
+  {
+    return !m_restore_file.empty();
+  }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_restore_file(void)const
+    {
+      return m_restore_file;
+    }
+
+  //----------------------------------------------------------------------------
+  bool simulation_options::is_compile(void)const
+  {
+    return !m_compile_file.empty();
+  }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_compile_file(void)const
+    {
+      return m_compile_file;
+    }
+
+  //----------------------------------------------------------------------------
+  bool simulation_options::is_batch(void)const
+  {
+    return !m_batch_file.empty();
+  }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_batch_file(void)const
+    {
+      return m_batch_file;
+    }
+
+  //----------------------------------------------------------------------------
+  const unsigned int & simulation_options::get_batch_lanes(void)const
+    {
+      return m_batch_lanes;
+    }
+
+  //----------------------------------------------------------------------------
+  bool simulation_options::is_probe(void)const
+  {
+    return !m_probe_file.empty();
+  }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_probe_file(void)const
+    {
+      return m_probe_file;
+    }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_probe_output_file(void)const
+    {
+      return m_probe_output_file;
+    }
+
+  //----------------------------------------------------------------------------
+  const bool & simulation_options::is_detect_period(void)const
+    {
+      return m_detect_period;
+    }
+
+  //----------------------------------------------------------------------------
+  const bool & simulation_options::is_headless(void)const
+    {
+      return m_headless;
+    }
+
+  //----------------------------------------------------------------------------
+  const bool & simulation_options::is_async_display(void)const
+    {
+      return m_async_display;
+    }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_trace_file(void)const
+    {
+      return m_trace_file;
+    }
+
+  //----------------------------------------------------------------------------
+  const std::string & simulation_options::get_stats_file(void)const
+    {
+      return m_stats_file;
+    }
+
+  //----------------------------------------------------------------------------
+  const unsigned int & simulation_options::get_stats_interval(void)const
+    {
+      return m_stats_interval;
+    }
+
+  //----------------------------------------------------------------------------
+  std::string simulation_options::engine2string(const t_engine & p_engine)
+  {
+    switch(p_engine)
+      {
+      case t_engine::CELL:
+        return "cell";
+        break;
+      case t_engine::PARTITION:
+        return "partition";
+        break;
+      case t_engine::BITPLANE:
+        return "bitplane";
+        break;
+      case t_engine::PARALLEL:
+        return "parallel";
+        break;
+      case t_engine::HASHLIFE:
+        return "hashlife";
+        break;
+      case t_engine::BAND:
+        return "band";
+        break;
+      default:
+        throw quicky_exception::quicky_logic_exception("Unknown engine value",__LINE__,__FILE__);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  simulation_options::t_engine simulation_options::string2engine(const std::string & p_name)
+  {
+    if("cell" == p_name)
+      {
+        return t_engine::CELL;
+      }
+    else if("partition" == p_name)
+      {
+        return t_engine::PARTITION;
+      }
+    else if("bitplane" == p_name)
+      {
+        return t_engine::BITPLANE;
+      }
+    else if("parallel" == p_name)
+      {
+        return t_engine::PARALLEL;
+      }
+    else if("hashlife" == p_name)
+      {
+        return t_engine::HASHLIFE;
+      }
+    else if("band" == p_name)
+      {
+        return t_engine::BAND;
+      }
+    throw quicky_exception::quicky_runtime_exception("Unknown engine \"" + p_name + "\"",__LINE__,__FILE__);
+  }
+
+  //----------------------------------------------------------------------------
+  bool simulation_options::get_value(const std::string & p_arg,
+                                     const std::string & p_name,
+                                     std::string & p_value)
+  {
+    std::string l_prefix = "--" + p_name + "=";
+    if(p_arg.compare(0,l_prefix.size(),l_prefix))
+      {
+        return false;
+      }
+    p_value = p_arg.substr(l_prefix.size());
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int simulation_options::to_unsigned(const std::string & p_name,
+                                               const std::string & p_value)
+  {
+    char * l_end = nullptr;
+    unsigned long l_value = strtoul(p_value.c_str(),&l_end,10);
+    if(p_value.empty() || '\0' != *l_end)
+      {
+        throw quicky_exception::quicky_runtime_exception("Bad value \"" + p_value + "\" for option " + p_name,__LINE__,__FILE__);
+      }
+    return (unsigned int)l_value;
+  }
+}
+#endif // SIMULATION_OPTIONS_H
+//EOF
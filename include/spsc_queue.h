@@ -0,0 +1,89 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+namespace wireworld_systemc
+{
+  // Bounded lock free queue with a single producer thread and a single
+  // consumer thread. Push fails instead of waiting when queue is full
+  template <class T>
+    class spsc_queue
+    {
+    public:
+      inline spsc_queue(const size_t & p_capacity);
+
+      // Called by producer thread only
+      inline bool push(const T & p_item);
+      // Called by consumer thread only
+      inline bool pop(T & p_item);
+    private:
+      std::vector<T> m_slots;
+      // Next slot to read, written by consumer
+      std::atomic<size_t> m_head;
+      // Keep indexes written by different threads in different cache lines
+      char m_padding[64];
+      // Next slot to write, written by producer
+      std::atomic<size_t> m_tail;
+    };
+
+  //----------------------------------------------------------------------------
+  template <class T>
+    spsc_queue<T>::spsc_queue(const size_t & p_capacity):
+    m_slots(p_capacity + 1),
+    m_head(0),
+    m_tail(0)
+    {
+    }
+
+  //----------------------------------------------------------------------------
+  template <class T>
+    bool spsc_queue<T>::push(const T & p_item)
+    {
+      size_t l_tail = m_tail.load(std::memory_order_relaxed);
+      size_t l_next = (l_tail + 1) % m_slots.size();
+      if(l_next == m_head.load(std::memory_order_acquire))
+        {
+          return false;
+        }
+      m_slots[l_tail] = p_item;
+      m_tail.store(l_next,std::memory_order_release);
+      return true;
+    }
+
+  //----------------------------------------------------------------------------
+  template <class T>
+    bool spsc_queue<T>::pop(T & p_item)
+    {
+      size_t l_head = m_head.load(std::memory_order_relaxed);
+      if(l_head == m_tail.load(std::memory_order_acquire))
+        {
+          return false;
+        }
+      p_item = m_slots[l_head];
+      m_head.store((l_head + 1) % m_slots.size(),std::memory_order_release);
+      return true;
+    }
+}
+#endif // SPSC_QUEUE_H
+//EOF
@@ -28,14 +28,16 @@ namespace wireworld_systemc
   {
   public:
     top(sc_module_name p_name,
-        const std::vector<std::pair<uint32_t,uint32_t> > & p_copper_cells,
-        const std::vector<std::pair<uint32_t,uint32_t> > & p_tail_cells,
-        const std::vector<std::pair<uint32_t,uint32_t> > & p_electron_cells,
+        const cell_index & p_index,
+        const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+        const uint64_t & p_generation,
 	const wireworld_common::wireworld_configuration & p_conf,
 	const uint32_t & p_x_max,
 	const uint32_t & p_y_max,
 	const wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
-	const wireworld_common::wireworld_types::t_neighbours & p_neighbours);
+        const simulation_options & p_options);
+    inline const uint64_t & get_generation(void)const;
+    inline const sc_time & get_clock_period(void)const;
   private:
     sc_clock m_clk;
     wireworld m_wireworld;
@@ -43,20 +45,32 @@ namespace wireworld_systemc
 
   //----------------------------------------------------------------------------
   top::top(sc_module_name p_name,
-           const std::vector<std::pair<uint32_t,uint32_t> > & p_copper_cells,
-           const std::vector<std::pair<uint32_t,uint32_t> > & p_tail_cells,
-           const std::vector<std::pair<uint32_t,uint32_t> > & p_electron_cells,
+           const cell_index & p_index,
+           const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+           const uint64_t & p_generation,
 	   const wireworld_common::wireworld_configuration & p_conf,
 	   const uint32_t & p_x_max,
 	   const uint32_t & p_y_max,
 	   const wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
-	   const wireworld_common::wireworld_types::t_neighbours & p_neighbours):
+           const simulation_options & p_options):
     sc_module(p_name),
     m_clk("clk",10.0,SC_NS,0.5,5.0,SC_NS,true),
-      m_wireworld("wireworld",p_copper_cells,p_tail_cells,p_electron_cells,p_conf,p_x_max,p_y_max,p_inactive_cells,p_neighbours)
+      m_wireworld("wireworld",p_index,p_states,p_generation,p_conf,p_x_max,p_y_max,p_inactive_cells,p_options)
     {
       m_wireworld.m_clk(m_clk);
     }
+
+  //----------------------------------------------------------------------------
+  const uint64_t & top::get_generation(void)const
+    {
+      return m_wireworld.get_generation();
+    }
+
+  //----------------------------------------------------------------------------
+  const sc_time & top::get_clock_period(void)const
+    {
+      return m_clk.period();
+    }
 }
 #endif // TOP_H
 //EOF
@@ -0,0 +1,332 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef VCD_WRITER_H
+#define VCD_WRITER_H
+
+#include "spsc_queue.h"
+#include "quicky_exception.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#ifdef WIREWORLD_ZLIB
+#include <zlib.h>
+#endif // WIREWORLD_ZLIB
+
+namespace wireworld_systemc
+{
+  // VCD file writer only emitting value changes. Text is formatted in large
+  // buffers written to disk by a background thread, file is gzip
+  // compressed when its name ends with ".gz". Write failures of background
+  // thread are reported by an exception at next flush, or by an error
+  // message at destruction
+  class vcd_writer
+  {
+  public:
+    typedef unsigned int t_variable_id;
+
+    inline vcd_writer(const std::string & p_file_name);
+    inline ~vcd_writer(void);
+
+    // Variables have to be declared before start
+    inline t_variable_id add_variable(const std::string & p_name,
+                                      const unsigned int & p_width);
+    // Write header, nothing is dumped before
+    inline void start(void);
+
+    inline void set_time(const uint64_t & p_time);
+    // Dump value if different from previous one
+    inline void change(const t_variable_id & p_id,
+                       const uint64_t & p_value);
+  private:
+    inline static bool is_compressed(const std::string & p_file_name);
+    // Throw if writer thread failed, then hand buffer over to it
+    inline void flush(void);
+    inline void push_buffer(void);
+    // Background thread loop
+    inline void run(void);
+    // Return false if buffer could not be written entirely
+    inline bool write(const std::string & p_buffer);
+    // Close file, return false on failure
+    inline bool close(void);
+
+    static const size_t m_buffer_size = 1 << 20;
+
+    std::string m_file_name;
+    std::FILE * m_file;
+#ifdef WIREWORLD_ZLIB
+    gzFile m_gz_file;
+#endif // WIREWORLD_ZLIB
+
+    std::vector<std::string> m_names;
+    std::vector<unsigned int> m_widths;
+    std::vector<std::string> m_codes;
+    std::vector<uint64_t> m_values;
+    std::vector<bool> m_dumped;
+
+    uint64_t m_time;
+    bool m_time_dumped;
+
+    std::string * m_buffer;
+    spsc_queue<std::string*> m_buffers;
+    std::atomic<bool> m_terminate;
+    // Set by writer thread when a write fails, next buffers are dropped
+    std::atomic<bool> m_error;
+    // Error already reported by an exception
+    bool m_error_reported;
+    std::thread m_thread;
+  };
+
+  //----------------------------------------------------------------------------
+  vcd_writer::vcd_writer(const std::string & p_file_name):
+    m_file_name(p_file_name),
+    m_file(nullptr),
+#ifdef WIREWORLD_ZLIB
+    m_gz_file(nullptr),
+#endif // WIREWORLD_ZLIB
+    m_time(0),
+    m_time_dumped(false),
+    m_buffer(new std::string()),
+    m_buffers(8),
+    m_terminate(false),
+    m_error(false),
+    m_error_reported(false)
+    {
+      if(is_compressed(p_file_name))
+        {
+#ifdef WIREWORLD_ZLIB
+          m_gz_file = gzopen(p_file_name.c_str(),"wb1");
+          if(!m_gz_file)
+            {
+              throw quicky_exception::quicky_runtime_exception("Unable to create trace file \"" + p_file_name + "\"",__LINE__,__FILE__);
+            }
+#else
+          throw quicky_exception::quicky_runtime_exception("Compressed trace requires zlib support",__LINE__,__FILE__);
+#endif // WIREWORLD_ZLIB
+        }
+      else
+        {
+          m_file = std::fopen(p_file_name.c_str(),"wb");
+          if(!m_file)
+            {
+              throw quicky_exception::quicky_runtime_exception("Unable to create trace file \"" + p_file_name + "\"",__LINE__,__FILE__);
+            }
+        }
+      m_buffer->reserve(m_buffer_size + 4096);
+      m_thread = std::thread(&vcd_writer::run,this);
+    }
+
+  //----------------------------------------------------------------------------
+  vcd_writer::~vcd_writer(void)
+    {
+      // Destructor cannot throw so last buffer is pushed without check
+      push_buffer();
+      m_terminate.store(true,std::memory_order_release);
+      m_thread.join();
+      delete m_buffer;
+      bool l_closed = close();
+      if((m_error.load(std::memory_order_acquire) && !m_error_reported) || !l_closed)
+        {
+          std::cout << "ERROR : Unable to write trace file \"" << m_file_name << "\", trace is incomplete" << std::endl ;
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  vcd_writer::t_variable_id vcd_writer::add_variable(const std::string & p_name,
+                                                     const unsigned int & p_width)
+  {
+    t_variable_id l_id = m_names.size();
+    // Identifier is id written in base 94 with printable characters
+    std::string l_code;
+    t_variable_id l_value = l_id;
+    do
+      {
+        l_code += (char)('!' + l_value % 94);
+        l_value /= 94;
+      }
+    while(l_value);
+    m_names.push_back(p_name);
+    m_widths.push_back(p_width);
+    m_codes.push_back(l_code);
+    m_values.push_back(0);
+    m_dumped.push_back(false);
+    return l_id;
+  }
+
+  //----------------------------------------------------------------------------
+  void vcd_writer::start(void)
+  {
+    m_buffer->append("$version wireworld_systemc $end\n$timescale 1 ps $end\n$scope module wireworld $end\n");
+    for(t_variable_id l_id = 0 ; l_id < m_names.size() ; ++l_id)
+      {
+        m_buffer->append("$var wire " + std::to_string(m_widths[l_id]) + " " + m_codes[l_id] + " " + m_names[l_id] + " $end\n");
+      }
+    m_buffer->append("$upscope $end\n$enddefinitions $end\n");
+  }
+
+  //----------------------------------------------------------------------------
+  void vcd_writer::set_time(const uint64_t & p_time)
+  {
+    if(p_time != m_time)
+      {
+        m_time = p_time;
+        m_time_dumped = false;
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void vcd_writer::change(const t_variable_id & p_id,
+                          const uint64_t & p_value)
+  {
+    if(m_dumped[p_id] && m_values[p_id] == p_value)
+      {
+        return;
+      }
+    m_dumped[p_id] = true;
+    m_values[p_id] = p_value;
+    if(!m_time_dumped)
+      {
+        m_buffer->push_back('#');
+        m_buffer->append(std::to_string(m_time));
+        m_buffer->push_back('\n');
+        m_time_dumped = true;
+      }
+    if(1 == m_widths[p_id])
+      {
+        m_buffer->push_back(p_value ? '1' : '0');
+      }
+    else
+      {
+        m_buffer->push_back('b');
+        bool l_significant = false;
+        for(unsigned int l_bit = m_widths[p_id] ; l_bit > 0 ; --l_bit)
+          {
+            bool l_value = (p_value >> (l_bit - 1)) & 1;
+            l_significant |= l_value;
+            if(l_significant || 1 == l_bit)
+              {
+                m_buffer->push_back(l_value ? '1' : '0');
+              }
+          }
+        m_buffer->push_back(' ');
+      }
+    m_buffer->append(m_codes[p_id]);
+    m_buffer->push_back('\n');
+    if(m_buffer->size() >= m_buffer_size)
+      {
+        flush();
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  bool vcd_writer::is_compressed(const std::string & p_file_name)
+  {
+    return p_file_name.size() > 3 && ".gz" == p_file_name.substr(p_file_name.size() - 3);
+  }
+
+  //----------------------------------------------------------------------------
+  void vcd_writer::flush(void)
+  {
+    if(m_error.load(std::memory_order_acquire))
+      {
+        m_error_reported = true;
+        throw quicky_exception::quicky_runtime_exception("Unable to write trace file \"" + m_file_name + "\"",__LINE__,__FILE__);
+      }
+    push_buffer();
+  }
+
+  //----------------------------------------------------------------------------
+  void vcd_writer::push_buffer(void)
+  {
+    if(m_buffer->empty())
+      {
+        return;
+      }
+    // Trace must be complete so simulation waits for writer thread
+    while(!m_buffers.push(m_buffer))
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    m_buffer = new std::string();
+    m_buffer->reserve(m_buffer_size + 4096);
+  }
+
+  //----------------------------------------------------------------------------
+  void vcd_writer::run(void)
+  {
+    while(true)
+      {
+        bool l_terminate = m_terminate.load(std::memory_order_acquire);
+        std::string * l_buffer = nullptr;
+        if(m_buffers.pop(l_buffer))
+          {
+            if(!m_error.load(std::memory_order_relaxed) && !write(*l_buffer))
+              {
+                m_error.store(true,std::memory_order_release);
+              }
+            delete l_buffer;
+          }
+        else if(l_terminate)
+          {
+            return;
+          }
+        else
+          {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  bool vcd_writer::write(const std::string & p_buffer)
+  {
+    if(m_file)
+      {
+        return p_buffer.size() == std::fwrite(p_buffer.data(),1,p_buffer.size(),m_file);
+      }
+#ifdef WIREWORLD_ZLIB
+    return (int)p_buffer.size() == gzwrite(m_gz_file,p_buffer.data(),p_buffer.size());
+#else
+    return false;
+#endif // WIREWORLD_ZLIB
+  }
+
+  //----------------------------------------------------------------------------
+  bool vcd_writer::close(void)
+  {
+    bool l_result = true;
+    if(m_file)
+      {
+        l_result = !std::fclose(m_file);
+      }
+#ifdef WIREWORLD_ZLIB
+    if(m_gz_file)
+      {
+        l_result = Z_OK == gzclose(m_gz_file);
+      }
+#endif // WIREWORLD_ZLIB
+    return l_result;
+  }
+}
+#endif // VCD_WRITER_H
+//EOF
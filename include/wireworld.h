@@ -23,11 +23,27 @@
 #include "wireworld_gui.h"
 #include "wireworld_configuration.h"
 #include "cell_factory.h"
+#include "partition.h"
+#include "delay_line.h"
+#include "electron_counters.h"
+#include "simulation_options.h"
+#include "engine_factory.h"
+#include "checkpoint.h"
+#include "period_detector.h"
+#include "async_renderer.h"
+#include "gui_display.h"
+#include "performance_counters.h"
+#include "probe_set.h"
+#ifdef COMPILE_TRACE_FEATURE
+#include "vcd_writer.h"
+#endif // COMPILE_TRACE_FEATURE
 #include "signal_handler.h"
 #include <vector>
 #include <set>
 #include <map>
 #include <queue>
+#include <algorithm>
+#include <cstdio>
 
 namespace wireworld_systemc
 {
@@ -36,73 +52,227 @@ namespace wireworld_systemc
   public:
     SC_HAS_PROCESS(wireworld);
     inline wireworld(sc_module_name p_name,
-                     const wireworld_common::wireworld_types::t_cell_list & p_copper_cells,
-                     const wireworld_common::wireworld_types::t_cell_list & p_tail_cells,
-                     const wireworld_common::wireworld_types::t_cell_list & p_electron_cells,
+                     const cell_index & p_index,
+                     const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                     const uint64_t & p_generation,
 		     const wireworld_common::wireworld_configuration & p_conf,
 		     const uint32_t & p_x_max,
 		     const uint32_t & p_y_max,
 		     const wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
-		     const wireworld_common::wireworld_types::t_neighbours & p_neighbours);
+                     const simulation_options & p_options);
     inline ~wireworld(void);
 
+    inline const uint64_t & get_generation(void)const;
+
     // Method inherited from signal_handler_listener_if
     inline void handle(int p_signal);
     // End of method inherited from signal_handler_listener_if
     sc_in<bool> m_clk;
   private:
+    // Callbacks of SystemC kernel
+    inline void start_of_simulation(void);
+    inline void end_of_simulation(void);
+
     inline void clk_management(void);
+    // Number of cells computing next generation and number of partitions
+    // they belong to
+    inline void get_activity(uint64_t & p_nb_updates,
+                             uint64_t & p_nb_active_partitions)const;
+    inline void check_reference(void)const;
+    // State of every cell indexed by cell id
+    inline void get_states(std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)const;
+    inline void check_reference(const wireworld_common::wireworld_types::t_coordinates & p_coordinates,
+                                const wireworld_common::wireworld_types::t_cell_state & p_state)const;
     
+    // Chains of cells having two neighbours are replaced by delay lines when
+    // p_delay_lines is set
+    inline void instanciate_cells(const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                  const bool & p_compact_names,
+                                  const bool & p_delay_lines);
+    // Maximal chains of at least two untraced cells having two neighbours,
+    // in neighbourhood order
+    inline void find_delay_lines(std::vector<std::vector<cell_index::t_cell_id>> & p_chains)const;
+    inline bool is_delay_line_cell(const cell_index::t_cell_id & p_id)const;
+    // Record probes at current generation, return true if one of them
+    // requests simulation stop
+    inline bool record_probes(void);
+    inline wireworld_common::wireworld_types::t_cell_state get_probe_state(const unsigned int & p_probe)const;
+    // Write p_prefix followed by hexadecimal id. Such names cannot collide
+    // with readable ones as they contain no underscore
+    inline static void compact_name(const char & p_prefix,
+                                    cell_index::t_cell_id p_id,
+                                    char * p_name);
+    inline void bind_cells(void);
 
-    typedef std::map<wireworld_common::wireworld_types::t_coordinates,std::vector<wireworld_common::wireworld_types::t_coordinates>> t_neighbours;
-    inline void instanciate_cells(const wireworld_common::wireworld_types::t_cell_list & p_cells,
-                                  const wireworld_common::wireworld_types::t_cell_state & p_state,
-                                  const t_neighbours & p_neighbours);
-
-    typedef unsigned int t_partition_id;
+    typedef partition::t_partition_id t_partition_id;
     typedef std::set<t_partition_id> t_active_partitions;
-    typedef std::map<wireworld_common::wireworld_types::t_coordinates,t_partition_id> t_partitionned_cells;
-    inline void compute_active_partitions(const wireworld_common::wireworld_types::t_cell_list & p_cells,
+    typedef partition::t_partitionned_cells t_partitionned_cells;
+    inline void instanciate_partitions(const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                       const unsigned int & p_partition_size,
+                                       const bool & p_event_driven);
+    inline bool is_traced(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const;
+#ifdef COMPILE_TRACE_FEATURE
+    inline void trace(sc_signal<bool> & p_signal);
+    // Dump value changes, called on both clock edges
+    inline void trace(void);
+#endif // COMPILE_TRACE_FEATURE
+    inline void compute_active_partitions(const std::vector<cell_index::t_cell_id> & p_cells,
 					  const t_partitionned_cells & p_partitionned_cells,
 					  t_active_partitions & p_active_partitions);
-    typedef std::map<wireworld_common::wireworld_types::t_coordinates,std::pair<cell_base*,sc_signal<bool>*>> t_cell_map;
-    t_cell_map m_cells;
+
+    const cell_index & m_index;
+    // Cells and their electron signal, indexed by cell id. They are located
+    // in m_arena. Cells belonging to a delay line have no cell and only ends
+    // of delay line have a signal
+    typedef std::vector<std::pair<cell_base*,sc_signal<bool>*>> t_cells;
+    t_cells m_cells;
+    // Number of non null cells of m_cells
+    unsigned int m_nb_instanciated_cells;
+    std::vector<delay_line*> m_delay_lines;
+    std::vector<partition*> m_partitions;
     sc_signal<bool> m_clk_sig;
-    sc_trace_file *m_trace_file;
+#ifdef COMPILE_TRACE_FEATURE
+    // Only created when trace is enabled by configuration
+    vcd_writer * m_trace_writer;
+    vcd_writer::t_variable_id m_clk_variable;
+    vcd_writer::t_variable_id m_nb_electron_variable;
+    vcd_writer::t_variable_id m_generation_variable;
+    // Signals of cells located in trace window
+    std::vector<std::pair<sc_signal<bool>*,vcd_writer::t_variable_id>> m_traced_signals;
+    uint64_t m_posedge_time;
+#endif // COMPILE_TRACE_FEATURE
     unsigned int m_nb_electron;
     unsigned int m_nb_tail;
+    // Electrons of next generation counted by groups of cells, by partitions
+    // and by delay lines. They are reduced in m_nb_electron on posedge
+    electron_counters m_electron_counters;
+    static const unsigned int m_cells_per_counter = 4096;
     sc_signal<uint32_t> m_nb_electron_sig;
     sc_signal<uint32_t> m_generation_sig;
     uint64_t m_generation;
     wireworld_common::wireworld_gui m_gui;
+    gui_display m_gui_display;
+    // No window is created and cells do not draw
+    bool m_headless;
+    // Display thread, it receives changes of cells instead of GUI when it
+    // exists
+    async_renderer * m_renderer;
+    // Where cells report their changes, null when headless
+    display_if * m_display;
     wireworld_common::wireworld_configuration m_config;
+    checkpoint m_checkpoint;
     bool m_stop;
+
+    // Zobrist hash of board maintained by cells when period detection is
+    // enabled
+    bool m_detect_period;
+    uint64_t m_hash;
+    period_detector m_period_detector;
+    // Once a period is known, generation whose state is the same as the one
+    // of last generation
+    uint64_t m_stop_generation;
     quicky_utils::signal_handler m_signal_handler;
+
+    // Engine compared generation by generation with SystemC engine
+    engine_if * m_reference;
+
+    // Only created when statistics are requested
+    performance_counters * m_counters;
+
+    // Only created when probes are requested
+    probe_set * m_probes;
+    std::string m_probe_output_file;
+    // Partition of each probe and index of probe in it, partition engine only
+    std::vector<std::pair<const partition*,unsigned int>> m_probe_locations;
+
+    // Declared last so that cells are destroyed before other members
+    arena m_arena;
   };
 
   //----------------------------------------------------------------------------
   void wireworld::clk_management(void)
   {
     m_clk_sig.write(m_clk.read());
+#ifdef COMPILE_TRACE_FEATURE
+    if(m_trace_writer)
+      {
+        trace();
+      }
+#endif // COMPILE_TRACE_FEATURE
     if(!m_clk_sig.read())
       {
+        m_nb_electron = m_electron_counters.reduce();
 	// GUI refresh management
-	if(m_generation >= m_config.get_start_cycle() && !(m_generation % m_config.get_refresh_interval()))
+	if(!m_headless && m_generation >= m_config.get_start_cycle() && !(m_generation % m_config.get_refresh_interval()))
 	  {
 #ifdef DEBUG_MESSAGES
 	    std::cout << m_generation << " : " << m_nb_electron << "E\t" << m_nb_tail << "Q" << std::endl ;
 #endif // DEBUG_MESSAGES
-	    m_gui.refresh();
-	    SDL_Delay(m_config.get_display_duration());
+            if(m_counters)
+              {
+                m_counters->start_gui();
+              }
+            if(m_renderer)
+              {
+                m_renderer->push_frame();
+              }
+            else
+              {
+                m_gui_display.update_screen();
+                SDL_Delay(m_config.get_display_duration());
+              }
+            if(m_counters)
+              {
+                m_counters->end_gui();
+              }
 	  }
 
+        if(m_reference)
+          {
+            check_reference();
+          }
+
         m_nb_electron_sig.write(m_nb_electron);
         m_generation_sig.write(m_generation);
+        // Sample stop request once so that snapshot and stop agree
+        bool l_stop = m_stop;
+        if(m_checkpoint.is_due(m_generation,l_stop))
+          {
+            std::vector<wireworld_common::wireworld_types::t_cell_state> l_states;
+            get_states(l_states);
+            m_checkpoint.save(m_generation,l_states);
+          }
+        if(m_detect_period && UINT64_MAX == m_stop_generation && m_period_detector.need_states(m_generation,m_hash))
+          {
+            std::vector<wireworld_common::wireworld_types::t_cell_state> l_states;
+            get_states(l_states);
+            if(m_period_detector.check(m_generation,m_hash,l_states))
+              {
+                uint64_t l_period = m_period_detector.get_period();
+                uint64_t l_phase = m_generation < m_config.get_nb_max_cycle() ? (m_config.get_nb_max_cycle() - m_generation) % l_period : 0;
+                m_stop_generation = m_generation + l_phase;
+                std::cout << "Generation " << m_generation << " : period of " << l_period << " generations detected, phase " << l_phase << " of period gives state of generation " << m_config.get_nb_max_cycle() << std::endl;
+              }
+          }
+        if(m_probes && record_probes())
+          {
+            l_stop = true;
+          }
         ++m_generation;
-        if(!m_stop && (m_nb_electron || m_nb_tail) && m_generation <= m_config.get_nb_max_cycle())
+        if(!l_stop && (m_nb_electron || m_nb_tail) && m_generation <= m_config.get_nb_max_cycle() && m_generation <= m_stop_generation)
           {
+            if(m_counters)
+              {
+                uint64_t l_nb_updates = 0;
+                uint64_t l_nb_active_partitions = 0;
+                get_activity(l_nb_updates,l_nb_active_partitions);
+                m_counters->generation(m_generation,1,0,l_nb_updates,m_nb_electron + m_nb_tail,l_nb_active_partitions);
+              }
             m_nb_tail = m_nb_electron;
-            m_nb_electron = 0;
+            if(m_reference)
+              {
+                m_reference->step();
+              }
           }
         else
           {
@@ -111,6 +281,130 @@ namespace wireworld_systemc
       }
   }
 
+  //----------------------------------------------------------------------------
+  const uint64_t & wireworld::get_generation(void)const
+    {
+      return m_generation;
+    }
+
+  //----------------------------------------------------------------------------
+  void wireworld::start_of_simulation(void)
+  {
+    if(m_counters)
+      {
+        m_counters->end_elaboration();
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::end_of_simulation(void)
+  {
+    if(m_counters)
+      {
+        m_counters->summary(m_generation - 1);
+      }
+    if(m_probes)
+      {
+        m_probes->save(m_probe_output_file,m_generation - 1);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::get_activity(uint64_t & p_nb_updates,
+                               uint64_t & p_nb_active_partitions)const
+  {
+    // Idle delay lines return before evaluating their cells
+    p_nb_updates = m_nb_instanciated_cells;
+    for(auto l_delay_line: m_delay_lines)
+      {
+        if(!l_delay_line->is_idle())
+          {
+            p_nb_updates += l_delay_line->get_nb_cells();
+          }
+      }
+    p_nb_active_partitions = 0;
+    for(auto l_partition: m_partitions)
+      {
+        if(!l_partition->is_sleeping())
+          {
+            p_nb_updates += l_partition->get_nb_cells();
+            ++p_nb_active_partitions;
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::check_reference(void)const
+  {
+    for(cell_index::t_cell_id l_id = 0 ; l_id < m_cells.size() ; ++l_id)
+      {
+        if(m_cells[l_id].first)
+          {
+            check_reference(m_index.get_coordinates(l_id),m_cells[l_id].first->get_state());
+          }
+      }
+    for(auto l_delay_line: m_delay_lines)
+      {
+        for(unsigned int l_index = 0 ; l_index < l_delay_line->get_nb_cells() ; ++l_index)
+          {
+            check_reference(l_delay_line->get_coordinates(l_index),l_delay_line->get_state(l_index));
+          }
+      }
+    for(auto l_partition: m_partitions)
+      {
+        for(unsigned int l_index = 0 ; l_index < l_partition->get_nb_cells() ; ++l_index)
+          {
+            check_reference(l_partition->get_coordinates(l_index),l_partition->get_state(l_index));
+          }
+      }
+    if(m_nb_electron != m_reference->get_nb_electron() || m_nb_tail != m_reference->get_nb_tail())
+      {
+        std::stringstream l_stream;
+        l_stream << "Generation " << m_generation << " : " << m_nb_electron << "E " << m_nb_tail << "Q whereas reference engine has " << m_reference->get_nb_electron() << "E " << m_reference->get_nb_tail() << "Q";
+        throw quicky_exception::quicky_logic_exception(l_stream.str(),__LINE__,__FILE__);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::get_states(std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states)const
+  {
+    p_states.resize(m_index.get_nb_cells());
+    for(cell_index::t_cell_id l_id = 0 ; l_id < m_cells.size() ; ++l_id)
+      {
+        if(m_cells[l_id].first)
+          {
+            p_states[l_id] = m_cells[l_id].first->get_state();
+          }
+      }
+    for(auto l_delay_line: m_delay_lines)
+      {
+        for(unsigned int l_index = 0 ; l_index < l_delay_line->get_nb_cells() ; ++l_index)
+          {
+            p_states[l_delay_line->get_id(l_index)] = l_delay_line->get_state(l_index);
+          }
+      }
+    for(auto l_partition: m_partitions)
+      {
+        for(unsigned int l_index = 0 ; l_index < l_partition->get_nb_cells() ; ++l_index)
+          {
+            p_states[l_partition->get_id(l_index)] = l_partition->get_state(l_index);
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::check_reference(const wireworld_common::wireworld_types::t_coordinates & p_coordinates,
+                                  const wireworld_common::wireworld_types::t_cell_state & p_state)const
+  {
+    wireworld_common::wireworld_types::t_cell_state l_reference_state = m_reference->get_state(p_coordinates);
+    if(l_reference_state != p_state)
+      {
+        std::stringstream l_stream;
+        l_stream << "Generation " << m_generation << " : cell(" << p_coordinates.first << "," << p_coordinates.second << ") is " << wireworld_common::wireworld_types::cell_state2string(p_state) << " whereas it is " << wireworld_common::wireworld_types::cell_state2string(l_reference_state) << " with reference engine";
+        throw quicky_exception::quicky_logic_exception(l_stream.str(),__LINE__,__FILE__);
+      }
+  }
+
   //----------------------------------------------------------------------------
   void wireworld::handle(int p_signal)
     {
@@ -120,136 +414,572 @@ namespace wireworld_systemc
 
   //----------------------------------------------------------------------------
   wireworld::wireworld(sc_module_name p_name,
-                       const wireworld_common::wireworld_types::t_cell_list & p_copper_cells,
-                       const wireworld_common::wireworld_types::t_cell_list & p_tail_cells,
-                       const wireworld_common::wireworld_types::t_cell_list & p_electron_cells,
+                       const cell_index & p_index,
+                       const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                       const uint64_t & p_generation,
 		       const wireworld_common::wireworld_configuration & p_conf,
 		       const uint32_t & p_x_max,
 		       const uint32_t & p_y_max,
                        const wireworld_common::wireworld_types::t_cell_list & p_inactive_cells,
-		       const wireworld_common::wireworld_types::t_neighbours & p_neighbours):
+                       const simulation_options & p_options):
     sc_module(p_name),
     m_clk("clk_in"),
+    m_index(p_index),
+    m_nb_instanciated_cells(0),
     m_clk_sig("clk"),
-    m_trace_file(nullptr),
+#ifdef COMPILE_TRACE_FEATURE
+    m_trace_writer(nullptr),
+    m_clk_variable(0),
+    m_nb_electron_variable(0),
+    m_generation_variable(0),
+    m_posedge_time(0),
+#endif // COMPILE_TRACE_FEATURE
     m_nb_electron_sig("nb_electron"),
     m_generation_sig("generation"),
-    m_generation(0),
+    m_generation(p_generation),
+    m_gui_display(m_gui,p_x_max + 2,p_y_max + 2),
+    m_headless(p_options.is_headless()),
+    m_renderer(nullptr),
+    m_display(nullptr),
     m_config(p_conf),
+    m_checkpoint(p_options.get_checkpoint_file(),p_options.get_checkpoint_interval(),p_generation,p_index,m_config,p_x_max,p_y_max,p_inactive_cells),
     m_stop(false),
-    m_signal_handler(*this)
+    m_detect_period(p_options.is_detect_period()),
+    m_hash(0),
+    m_stop_generation(UINT64_MAX),
+    m_signal_handler(*this),
+    m_reference(nullptr),
+    m_counters(nullptr),
+    m_probes(nullptr),
+    m_probe_output_file(p_options.get_probe_output_file())
     {
+      if(!p_options.get_stats_file().empty())
+        {
+          m_counters = new performance_counters(p_options.get_stats_file(),p_options.get_stats_interval());
+        }
+
+      std::cout << "Number of active cells in design : " << p_index.get_nb_cells() << std::endl ;
 
-      std::cout << "Number of active cells in design : " << p_copper_cells.size() << std::endl ;
+      if(p_options.is_probe())
+        {
+          m_probes = new probe_set(p_options.get_probe_file(),p_index);
+        }
+
+      if(p_options.is_check())
+        {
+          m_reference = engine_factory::create(p_options.get_check_engine(),p_index,p_states,p_options);
+        }
 
-      m_trace_file = sc_create_vcd_trace_file("trace");
       SC_METHOD(clk_management);
       dont_initialize();
       sensitive << m_clk;
 
-      sc_trace(m_trace_file,m_clk_sig,m_clk_sig.name());
-      sc_trace(m_trace_file,m_nb_electron_sig,m_nb_electron_sig.name());
-      sc_trace(m_trace_file,m_generation_sig,m_generation_sig.name());
+#ifdef COMPILE_TRACE_FEATURE
+      if(m_config.get_trace())
+        {
+          m_trace_writer = new vcd_writer(p_options.get_trace_file());
+          m_clk_variable = m_trace_writer->add_variable(m_clk_sig.name(),1);
+          m_nb_electron_variable = m_trace_writer->add_variable(m_nb_electron_sig.name(),32);
+          m_generation_variable = m_trace_writer->add_variable(m_generation_sig.name(),32);
+        }
+#endif // COMPILE_TRACE_FEATURE
+
+      m_nb_tail = std::count(p_states.begin(),p_states.end(),wireworld_common::wireworld_types::t_cell_state::TAIL);
+      m_nb_electron = std::count(p_states.begin(),p_states.end(),wireworld_common::wireworld_types::t_cell_state::ELECTRON);
 
-      m_nb_tail = p_tail_cells.size();
-      m_nb_electron = p_electron_cells.size();
+      if(m_detect_period)
+        {
+          for(cell_index::t_cell_id l_id = 0 ; l_id < p_states.size() ; ++l_id)
+            {
+              m_hash ^= period_detector::get_key(p_index.get_coordinates(l_id).first,p_index.get_coordinates(l_id).second,p_states[l_id]);
+            }
+        }
 
       // Create GUI
-      m_gui.createWindow(p_x_max + 2,p_y_max + 2);
+      if(!m_headless)
+        {
+          m_gui.createWindow(p_x_max + 2,p_y_max + 2);
+        }
+      if(!m_headless && p_options.is_async_display())
+        {
+          m_renderer = new async_renderer(m_gui,p_x_max + 2,p_y_max + 2,m_config.get_display_duration());
+          m_display = m_renderer;
+        }
+      else if(!m_headless)
+        {
+          m_display = &m_gui_display;
+        }
 
-      // Instanciate cells
-      instanciate_cells(p_electron_cells,wireworld_common::wireworld_types::t_cell_state::ELECTRON,p_neighbours);
-      instanciate_cells(p_tail_cells,wireworld_common::wireworld_types::t_cell_state::TAIL,p_neighbours);
-      instanciate_cells(p_copper_cells,wireworld_common::wireworld_types::t_cell_state::COPPER,p_neighbours);
+      if(simulation_options::t_engine::PARTITION == p_options.get_engine())
+        {
+          instanciate_partitions(p_states,p_options.get_partition_size(),p_options.is_event_driven());
+          if(m_probes)
+            {
+              m_probe_locations.resize(m_probes->get_nb_probes(),std::pair<const partition*,unsigned int>(nullptr,0));
+              for(auto l_partition: m_partitions)
+                {
+                  for(unsigned int l_index = 0 ; l_index < l_partition->get_nb_cells() ; ++l_index)
+                    {
+                      for(unsigned int l_probe = 0 ; m_probes->is_probed(l_partition->get_id(l_index)) && l_probe < m_probes->get_nb_probes() ; ++l_probe)
+                        {
+                          if(m_probes->get_id(l_probe) == l_partition->get_id(l_index))
+                            {
+                              m_probe_locations[l_probe] = std::pair<const partition*,unsigned int>(l_partition,l_index);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+      else
+        {
+          instanciate_cells(p_states,p_options.is_compact_names(),p_options.is_delay_lines());
+        }
 
-      // Display inactive cells
-      for(auto l_iter:p_inactive_cells)
-	{
-	  m_gui.displayCell(l_iter.first,l_iter.second,wireworld_common::wireworld_types::t_cell_state::COPPER);
-	}
+      // Electrons of initial generation are reduced on first posedge
+      if(m_nb_electron)
+        {
+          m_electron_counters.get(0) = m_nb_electron;
+        }
 
-      // Bind cells
-      for(auto l_iter: p_copper_cells)
+      // Display inactive cells
+      if(m_display)
         {
-          // Find cell
-          t_cell_map::iterator l_cell_iter = m_cells.find(l_iter);
-          assert(m_cells.end() != l_cell_iter);
-
-          // Bind unique clock signal and electron signals
-          l_cell_iter->second.first->bind_clk(m_clk_sig);
-          l_cell_iter->second.first->bind_electron(*(l_cell_iter->second.second));
-
-	  if(p_conf.get_trace() && l_iter.first >= p_conf.get_trace_x_origin() && l_iter.first < (p_conf.get_trace_x_origin() + p_conf.get_trace_width()) && l_iter.second >= p_conf.get_trace_y_origin() && l_iter.second < (p_conf.get_trace_y_origin() + p_conf.get_trace_height()))
-	    {
-	      sc_trace(m_trace_file,*(l_cell_iter->second.second),l_cell_iter->second.second->name());
-	    }
-
-          // Search for neighbours coordinates
-          t_neighbours::const_iterator l_neighbour_list_iter = p_neighbours.find(l_iter);
-          assert(p_neighbours.end() != l_neighbour_list_iter);
-
-          // Iterate on neighbours
-          unsigned int l_index = 0;
-          for(auto l_neighbour_iter:l_neighbour_list_iter->second)
+          for(auto l_iter:p_inactive_cells)
             {
-              t_cell_map::iterator l_neighbour_cell_iter = m_cells.find(l_neighbour_iter);
-              assert(m_cells.end() != l_neighbour_cell_iter);
-
-              // Bind neighbour
-              l_cell_iter->second.first->bind_neighbour(*(l_neighbour_cell_iter->second.second),l_index);
-              ++l_index;
+              m_display->display_cell(l_iter.first,l_iter.second,wireworld_common::wireworld_types::t_cell_state::COPPER);
             }
         }
 
-      std::cout << "Number of cells instanciated : " << m_cells.size() << std::endl;
-      m_gui.refresh();
+      if(simulation_options::t_engine::CELL == p_options.get_engine())
+        {
+          bind_cells();
+          std::cout << "Number of cells instanciated : " << m_nb_instanciated_cells << std::endl;
+          if(p_options.is_delay_lines())
+            {
+              std::cout << "Number of delay lines instanciated : " << m_delay_lines.size() << std::endl;
+            }
+        }
+      else
+        {
+          std::cout << "Number of partitions instanciated : " << m_partitions.size() << std::endl;
+        }
+      if(m_renderer)
+        {
+          m_renderer->push_frame();
+        }
+      else if(!m_headless)
+        {
+          m_gui_display.update_screen();
+        }
+#ifdef COMPILE_TRACE_FEATURE
+      if(m_trace_writer)
+        {
+          m_trace_writer->start();
+          m_trace_writer->set_time(sc_time_stamp().value());
+          m_trace_writer->change(m_clk_variable,0);
+          m_trace_writer->change(m_nb_electron_variable,m_nb_electron_sig.read());
+          m_trace_writer->change(m_generation_variable,m_generation_sig.read());
+          for(auto l_iter: m_traced_signals)
+            {
+              m_trace_writer->change(l_iter.second,l_iter.first->read());
+            }
+        }
+#endif // COMPILE_TRACE_FEATURE
     }
 
   //----------------------------------------------------------------------------
-  void wireworld::instanciate_cells(const wireworld_common::wireworld_types::t_cell_list & p_cells,
-                                    const wireworld_common::wireworld_types::t_cell_state & p_state,
-                                    const wireworld::t_neighbours & p_neighbours)
+  void wireworld::bind_cells(void)
+  {
+    for(cell_index::t_cell_id l_id = 0 ; l_id < m_cells.size() ; ++l_id)
+      {
+        if(!m_cells[l_id].first)
+          {
+            continue;
+          }
+        // Bind unique clock signal and electron signals
+        m_cells[l_id].first->bind_clk(m_clk_sig);
+        m_cells[l_id].first->bind_electron(*(m_cells[l_id].second));
+
+#ifdef COMPILE_TRACE_FEATURE
+        if(is_traced(m_index.get_coordinates(l_id)))
+          {
+            trace(*(m_cells[l_id].second));
+          }
+#endif // COMPILE_TRACE_FEATURE
+
+        // Bind neighbours
+        const cell_index::t_cell_id * l_neighbours = m_index.get_neighbours(l_id);
+        for(unsigned int l_index = 0 ; l_index < m_index.get_nb_neighbours(l_id) ; ++l_index)
+          {
+            assert(m_cells[l_neighbours[l_index]].second);
+            m_cells[l_id].first->bind_neighbour(*(m_cells[l_neighbours[l_index]].second),l_index);
+          }
+      }
+    for(auto l_delay_line: m_delay_lines)
+      {
+        l_delay_line->bind_clk(m_clk_sig);
+        for(unsigned int l_index = 0 ; l_index < l_delay_line->get_nb_inputs() ; ++l_index)
+          {
+            sc_signal<bool> * l_signal = m_cells[l_delay_line->get_input_id(l_index)].second;
+            assert(l_signal);
+            l_delay_line->bind_input(*l_signal,l_index);
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  bool wireworld::is_traced(const wireworld_common::wireworld_types::t_coordinates & p_coordinates)const
+  {
+#ifdef COMPILE_TRACE_FEATURE
+    return m_config.get_trace() && p_coordinates.first >= m_config.get_trace_x_origin() && p_coordinates.first < (m_config.get_trace_x_origin() + m_config.get_trace_width()) && p_coordinates.second >= m_config.get_trace_y_origin() && p_coordinates.second < (m_config.get_trace_y_origin() + m_config.get_trace_height());
+#else
+    return false;
+#endif // COMPILE_TRACE_FEATURE
+  }
+
+#ifdef COMPILE_TRACE_FEATURE
+  //----------------------------------------------------------------------------
+  void wireworld::trace(sc_signal<bool> & p_signal)
+  {
+    if(m_trace_writer)
+      {
+        m_traced_signals.push_back(std::pair<sc_signal<bool>*,vcd_writer::t_variable_id>(&p_signal,m_trace_writer->add_variable(p_signal.name(),1)));
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::trace(void)
+  {
+    if(m_clk.read())
+      {
+        // Cells switch during delta cycles following rising edge so their
+        // new values are dumped at falling edge with rising edge time
+        m_posedge_time = sc_time_stamp().value();
+        return;
+      }
+    m_trace_writer->set_time(m_posedge_time);
+    m_trace_writer->change(m_clk_variable,1);
+    m_trace_writer->change(m_nb_electron_variable,m_nb_electron_sig.read());
+    m_trace_writer->change(m_generation_variable,m_generation_sig.read());
+    for(auto l_iter: m_traced_signals)
+      {
+        m_trace_writer->change(l_iter.second,l_iter.first->read());
+      }
+    m_trace_writer->set_time(sc_time_stamp().value());
+    m_trace_writer->change(m_clk_variable,0);
+  }
+#endif // COMPILE_TRACE_FEATURE
+
+  //----------------------------------------------------------------------------
+  void wireworld::instanciate_cells(const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                    const bool & p_compact_names,
+                                    const bool & p_delay_lines)
   {
-    for(auto l_iter:p_cells)
-      {
-        if(m_cells.end() == m_cells.find(l_iter))
-          {
-            std::stringstream l_stream;
-            l_stream << l_iter.first << "_" << l_iter.second;
-            std::string l_name = l_stream.str();
-            std::string l_cell_name = "cell_" + l_name;
-            t_neighbours::const_iterator l_neighbour_iter = p_neighbours.find(l_iter);
-            assert(p_neighbours.end() != l_neighbour_iter);
-            m_cells.insert(t_cell_map::value_type(
-                                                  l_iter,
-                                                  std::pair<cell_base*,sc_signal<bool>*>(cell_factory::create(l_cell_name.c_str(),
-                                                                                                              l_neighbour_iter->second,
-                                                                                                              p_state,
-                                                                                                              l_iter.first,
-                                                                                                              l_iter.second,
-                                                                                                              &m_gui,
-                                                                                                              m_nb_electron
-                                                                                                              ),
-                                                                                         new sc_signal<bool>(l_name.c_str(),
-                                                                                                             wireworld_common::wireworld_types::t_cell_state::ELECTRON == p_state
-                                                                                                             )
-                                                                                         )
-                                                  )
-                           );
+    std::vector<std::vector<cell_index::t_cell_id>> l_chains;
+    std::vector<bool> l_chained(m_index.get_nb_cells(),false);
+    if(p_delay_lines)
+      {
+        find_delay_lines(l_chains);
+        for(auto & l_chain: l_chains)
+          {
+            for(auto l_id: l_chain)
+              {
+                l_chained[l_id] = true;
+              }
+          }
+      }
+
+    // Cells count in counter of their group of ids, delay lines in their own
+    unsigned int l_nb_cell_counters = (m_index.get_nb_cells() + m_cells_per_counter - 1) / m_cells_per_counter;
+    m_electron_counters.resize(l_nb_cell_counters + l_chains.size());
+
+    m_cells.reserve(m_index.get_nb_cells());
+    char l_name[32];
+    char l_cell_name[40];
+    for(cell_index::t_cell_id l_id = 0 ; l_id < m_index.get_nb_cells() ; ++l_id)
+      {
+        if(l_chained[l_id])
+          {
+            m_cells.push_back(t_cells::value_type(nullptr,nullptr));
+            continue;
+          }
+        const wireworld_common::wireworld_types::t_coordinates & l_coordinates = m_index.get_coordinates(l_id);
+        // Readable names are only needed for cells that can appear in trace
+        if(!p_compact_names || is_traced(l_coordinates))
+          {
+            snprintf(l_name,sizeof(l_name),"%u_%u",l_coordinates.first,l_coordinates.second);
+            snprintf(l_cell_name,sizeof(l_cell_name),"cell_%s",l_name);
+          }
+        else
+          {
+            compact_name('s',l_id,l_name);
+            compact_name('c',l_id,l_cell_name);
+          }
+        m_cells.push_back(std::pair<cell_base*,sc_signal<bool>*>(cell_factory::create(l_cell_name,
+                                                                                      m_index,
+                                                                                      l_id,
+                                                                                      p_states[l_id],
+                                                                                      m_display,
+                                                                                      m_electron_counters.get(l_id / m_cells_per_counter),
+                                                                                      m_detect_period ? &m_hash : nullptr,
+                                                                                      m_arena
+                                                                                      ),
+                                                                 m_arena.create<sc_signal<bool>>(l_name,
+                                                                                                 wireworld_common::wireworld_types::t_cell_state::ELECTRON == p_states[l_id]
+                                                                                                 )
+                                                                 )
+                          );
+        ++m_nb_instanciated_cells;
+      }
+
+    m_delay_lines.reserve(l_chains.size());
+    for(auto & l_chain: l_chains)
+      {
+        const wireworld_common::wireworld_types::t_coordinates & l_coordinates = m_index.get_coordinates(l_chain.front());
+        snprintf(l_name,sizeof(l_name),"delay_line_%u_%u",l_coordinates.first,l_coordinates.second);
+        delay_line * l_delay_line = new delay_line(l_name,
+                                                   m_index,
+                                                   l_chain,
+                                                   p_states,
+                                                   m_display,
+                                                   m_electron_counters.get(l_nb_cell_counters + m_delay_lines.size()),
+                                                   m_detect_period ? &m_hash : nullptr);
+        m_delay_lines.push_back(l_delay_line);
+        for(unsigned int l_index = 0 ; l_index < l_delay_line->get_nb_outputs() ; ++l_index)
+          {
+            m_cells[l_delay_line->get_output_id(l_index)].second = &(l_delay_line->get_output(l_index));
           }
       }
   }
 
   //----------------------------------------------------------------------------
-  void wireworld::compute_active_partitions(const wireworld_common::wireworld_types::t_cell_list & p_cells,
+  void wireworld::find_delay_lines(std::vector<std::vector<cell_index::t_cell_id>> & p_chains)const
+  {
+    std::vector<bool> l_visited(m_index.get_nb_cells(),false);
+    for(cell_index::t_cell_id l_id = 0 ; l_id < m_index.get_nb_cells() ; ++l_id)
+      {
+        if(l_visited[l_id] || !is_delay_line_cell(l_id))
+          {
+            continue;
+          }
+        l_visited[l_id] = true;
+        // Walk from cell in both directions until reaching a cell that cannot
+        // be chained or coming back to it
+        std::vector<cell_index::t_cell_id> l_sides[2];
+        bool l_loop = false;
+        for(unsigned int l_side = 0 ; l_side < 2 && !l_loop ; ++l_side)
+          {
+            cell_index::t_cell_id l_previous = l_id;
+            cell_index::t_cell_id l_current = m_index.get_neighbours(l_id)[l_side];
+            while(is_delay_line_cell(l_current))
+              {
+                if(l_id == l_current)
+                  {
+                    l_loop = true;
+                    break;
+                  }
+                l_visited[l_current] = true;
+                l_sides[l_side].push_back(l_current);
+                const cell_index::t_cell_id * l_neighbours = m_index.get_neighbours(l_current);
+                cell_index::t_cell_id l_next = l_previous == l_neighbours[0] ? l_neighbours[1] : l_neighbours[0];
+                l_previous = l_current;
+                l_current = l_next;
+              }
+          }
+        std::vector<cell_index::t_cell_id> l_chain(l_sides[1].rbegin(),l_sides[1].rend());
+        l_chain.push_back(l_id);
+        l_chain.insert(l_chain.end(),l_sides[0].begin(),l_sides[0].end());
+        if(l_chain.size() >= 2)
+          {
+            p_chains.push_back(l_chain);
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  bool wireworld::is_delay_line_cell(const cell_index::t_cell_id & p_id)const
+  {
+    // Traced and probed cells need their own signal
+    return 2 == m_index.get_nb_neighbours(p_id) && !is_traced(m_index.get_coordinates(p_id)) && !(m_probes && m_probes->is_probed(p_id));
+  }
+
+  //----------------------------------------------------------------------------
+  bool wireworld::record_probes(void)
+  {
+    bool l_stop = false;
+    for(unsigned int l_probe = 0 ; l_probe < m_probes->get_nb_probes() ; ++l_probe)
+      {
+        if(m_probes->record(l_probe,m_generation,get_probe_state(l_probe)) && !l_stop)
+          {
+            m_probes->report_stop(l_probe,m_generation);
+            l_stop = true;
+          }
+      }
+    return l_stop;
+  }
+
+  //----------------------------------------------------------------------------
+  wireworld_common::wireworld_types::t_cell_state wireworld::get_probe_state(const unsigned int & p_probe)const
+  {
+    if(m_probe_locations.empty())
+      {
+        return m_cells[m_probes->get_id(p_probe)].first->get_state();
+      }
+    return m_probe_locations[p_probe].first->get_state(m_probe_locations[p_probe].second);
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::compact_name(const char & p_prefix,
+                               cell_index::t_cell_id p_id,
+                               char * p_name)
+  {
+    static const char l_digits[] = "0123456789abcdef";
+    char l_reversed[2 * sizeof(cell_index::t_cell_id)];
+    unsigned int l_size = 0;
+    do
+      {
+        l_reversed[l_size++] = l_digits[p_id & 0xF];
+        p_id >>= 4;
+      }
+    while(p_id);
+    *p_name++ = p_prefix;
+    while(l_size)
+      {
+        *p_name++ = l_reversed[--l_size];
+      }
+    *p_name = '\0';
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::instanciate_partitions(const std::vector<wireworld_common::wireworld_types::t_cell_state> & p_states,
+                                         const unsigned int & p_partition_size,
+                                         const bool & p_event_driven)
+  {
+    // Partitions are square tiles of the board, they may come with index
+    cell_index::t_cell_id l_nb_cells = m_index.get_nb_cells();
+    t_partitionned_cells l_partitionned_cells;
+    if(m_index.get_partitions() && p_partition_size == m_index.get_partition_size())
+      {
+        l_partitionned_cells.assign(m_index.get_partitions(),m_index.get_partitions() + l_nb_cells);
+      }
+    else
+      {
+        partition::assign(m_index,p_partition_size,l_partitionned_cells);
+      }
+    std::vector<std::vector<cell_index::t_cell_id>> l_partition_cells;
+    std::vector<uint32_t> l_local_indexes(l_nb_cells);
+    for(cell_index::t_cell_id l_id = 0 ; l_id < l_nb_cells ; ++l_id)
+      {
+        t_partition_id l_partition_id = l_partitionned_cells[l_id];
+        if(l_partition_id >= l_partition_cells.size())
+          {
+            l_partition_cells.resize(l_partition_id + 1);
+          }
+        l_local_indexes[l_id] = l_partition_cells[l_partition_id].size();
+        l_partition_cells[l_partition_id].push_back(l_id);
+      }
+
+    // Cells read by another partition or traced need a signal
+    partition::t_exposed_cells l_exposed_cells(l_nb_cells,false);
+    for(cell_index::t_cell_id l_id = 0 ; l_id < l_nb_cells ; ++l_id)
+      {
+        if(is_traced(m_index.get_coordinates(l_id)))
+          {
+            l_exposed_cells[l_id] = true;
+          }
+        const cell_index::t_cell_id * l_neighbours = m_index.get_neighbours(l_id);
+        for(unsigned int l_index = 0 ; l_index < m_index.get_nb_neighbours(l_id) ; ++l_index)
+          {
+            if(l_partitionned_cells[l_neighbours[l_index]] != l_partitionned_cells[l_id])
+              {
+                l_exposed_cells[l_neighbours[l_index]] = true;
+              }
+          }
+      }
+
+    // Partitions containing electrons or tails, or having an electron on
+    // their border are active at startup
+    t_active_partitions l_active_partitions;
+    std::vector<cell_index::t_cell_id> l_living_cells;
+    for(cell_index::t_cell_id l_id = 0 ; l_id < l_nb_cells ; ++l_id)
+      {
+        if(wireworld_common::wireworld_types::t_cell_state::COPPER != p_states[l_id])
+          {
+            l_living_cells.push_back(l_id);
+          }
+        if(wireworld_common::wireworld_types::t_cell_state::ELECTRON == p_states[l_id])
+          {
+            l_living_cells.insert(l_living_cells.end(),m_index.get_neighbours(l_id),m_index.get_neighbours(l_id) + m_index.get_nb_neighbours(l_id));
+          }
+      }
+    compute_active_partitions(l_living_cells,l_partitionned_cells,l_active_partitions);
+
+    // Create partitions, each one having its own electron counter
+    m_partitions.reserve(l_partition_cells.size());
+    m_electron_counters.resize(l_partition_cells.size());
+    for(t_partition_id l_id = 0 ; l_id < l_partition_cells.size() ; ++l_id)
+      {
+        std::stringstream l_stream;
+        l_stream << "partition_" << l_id;
+        m_partitions.push_back(new partition(l_stream.str().c_str(),
+                                             l_id,
+                                             m_index,
+                                             l_partition_cells[l_id],
+                                             p_states,
+                                             l_partitionned_cells,
+                                             l_local_indexes,
+                                             l_exposed_cells,
+                                             p_event_driven,
+                                             l_active_partitions.end() != l_active_partitions.find(l_id),
+                                             m_display,
+                                             m_electron_counters.get(l_id),
+                                             m_detect_period ? &m_hash : nullptr));
+      }
+
+    // Signals of exposed cells, indexed by cell id
+    std::vector<sc_signal<bool>*> l_signals(l_nb_cells,nullptr);
+    for(auto l_partition: m_partitions)
+      {
+        for(unsigned int l_index = 0 ; l_index < l_partition->get_nb_outputs() ; ++l_index)
+          {
+            l_signals[l_partition->get_output_id(l_index)] = &(l_partition->get_output(l_index));
+          }
+      }
+
+    // Bind clock and boundary signals
+    for(auto l_partition: m_partitions)
+      {
+        l_partition->bind_clk(m_clk_sig);
+        for(unsigned int l_index = 0 ; l_index < l_partition->get_nb_inputs() ; ++l_index)
+          {
+            sc_signal<bool> * l_signal = l_signals[l_partition->get_input_id(l_index)];
+            assert(l_signal);
+            l_partition->bind_input(*l_signal,l_index);
+          }
+      }
+
+#ifdef COMPILE_TRACE_FEATURE
+    // Trace exposed cells located in trace window
+    for(cell_index::t_cell_id l_id = 0 ; l_id < l_nb_cells ; ++l_id)
+      {
+        if(l_signals[l_id] && is_traced(m_index.get_coordinates(l_id)))
+          {
+            trace(*l_signals[l_id]);
+          }
+      }
+#endif // COMPILE_TRACE_FEATURE
+  }
+
+  //----------------------------------------------------------------------------
+  void wireworld::compute_active_partitions(const std::vector<cell_index::t_cell_id> & p_cells,
 					    const t_partitionned_cells & p_partitionned_cells,
 					    t_active_partitions & p_active_partitions)
   {
     for(auto l_iter : p_cells)
       {
-	t_partitionned_cells::const_iterator l_cell_iter = p_partitionned_cells.find(l_iter);
-	assert(p_partitionned_cells.end() != l_cell_iter);
-	t_partition_id l_partition_id = l_cell_iter->second;
+	assert(l_iter < p_partitionned_cells.size());
+	t_partition_id l_partition_id = p_partitionned_cells[l_iter];
 	if(p_active_partitions.end() == p_active_partitions.find(l_partition_id))
 	  {
 	    p_active_partitions.insert(l_partition_id);
@@ -260,11 +990,20 @@ namespace wireworld_systemc
   //----------------------------------------------------------------------------
   wireworld::~wireworld(void)
   {
-    sc_close_vcd_trace_file(m_trace_file);
-    for(auto l_iter:m_cells)
+    delete m_counters;
+    delete m_renderer;
+    delete m_reference;
+    delete m_probes;
+#ifdef COMPILE_TRACE_FEATURE
+    delete m_trace_writer;
+#endif // COMPILE_TRACE_FEATURE
+    for(auto l_iter:m_partitions)
+      {
+        delete l_iter;
+      }
+    for(auto l_iter:m_delay_lines)
       {
-        delete l_iter.second.first;
-        delete l_iter.second.second;
+        delete l_iter;
       }
   }
 }
@@ -0,0 +1,275 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef WORD_PACK_H
+#define WORD_PACK_H
+
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif // __AVX2__
+
+namespace wireworld_systemc
+{
+  // Bitwise operations on packs of 64 bits words used by bitplane kernels.
+  // scalar_pack holds a single word, simd_pack holds 4 words when compiled
+  // for AVX2, 2 words with SSE2 and is scalar_pack otherwise. Loads and
+  // stores are unaligned
+  class scalar_pack
+  {
+  public:
+    typedef uint64_t t_pack;
+    static const unsigned int m_nb_words = 1;
+
+    inline static t_pack load(const uint64_t * p_words);
+    inline static void store(uint64_t * p_words,
+                             const t_pack & p_pack);
+    inline static t_pack zero(void);
+    // Shift each word
+    inline static t_pack shift_left(const t_pack & p_pack,
+                                    const unsigned int & p_count);
+    inline static t_pack shift_right(const t_pack & p_pack,
+                                     const unsigned int & p_count);
+    inline static t_pack bit_and(const t_pack & p_pack1,
+                                 const t_pack & p_pack2);
+    inline static t_pack bit_or(const t_pack & p_pack1,
+                                const t_pack & p_pack2);
+    // p_pack1 & ~p_pack2
+    inline static t_pack and_not(const t_pack & p_pack1,
+                                 const t_pack & p_pack2);
+    inline static bool is_zero(const t_pack & p_pack);
+  };
+
+#if defined(__AVX2__) || defined(__SSE2__)
+  class simd_pack
+  {
+  public:
+#if defined(__AVX2__)
+    typedef __m256i t_pack;
+    static const unsigned int m_nb_words = 4;
+#else
+    typedef __m128i t_pack;
+    static const unsigned int m_nb_words = 2;
+#endif // __AVX2__
+
+    inline static t_pack load(const uint64_t * p_words);
+    inline static void store(uint64_t * p_words,
+                             const t_pack & p_pack);
+    inline static t_pack zero(void);
+    inline static t_pack shift_left(const t_pack & p_pack,
+                                    const unsigned int & p_count);
+    inline static t_pack shift_right(const t_pack & p_pack,
+                                     const unsigned int & p_count);
+    inline static t_pack bit_and(const t_pack & p_pack1,
+                                 const t_pack & p_pack2);
+    inline static t_pack bit_or(const t_pack & p_pack1,
+                                const t_pack & p_pack2);
+    inline static t_pack and_not(const t_pack & p_pack1,
+                                 const t_pack & p_pack2);
+    inline static bool is_zero(const t_pack & p_pack);
+  };
+#else
+  typedef scalar_pack simd_pack;
+#endif // __AVX2__ || __SSE2__
+
+  //----------------------------------------------------------------------------
+  scalar_pack::t_pack scalar_pack::load(const uint64_t * p_words)
+  {
+    return *p_words;
+  }
+
+  //----------------------------------------------------------------------------
+  void scalar_pack::store(uint64_t * p_words,
+                          const t_pack & p_pack)
+  {
+    *p_words = p_pack;
+  }
+
+  //----------------------------------------------------------------------------
+  scalar_pack::t_pack scalar_pack::zero(void)
+  {
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  scalar_pack::t_pack scalar_pack::shift_left(const t_pack & p_pack,
+                                              const unsigned int & p_count)
+  {
+    return p_pack << p_count;
+  }
+
+  //----------------------------------------------------------------------------
+  scalar_pack::t_pack scalar_pack::shift_right(const t_pack & p_pack,
+                                               const unsigned int & p_count)
+  {
+    return p_pack >> p_count;
+  }
+
+  //----------------------------------------------------------------------------
+  scalar_pack::t_pack scalar_pack::bit_and(const t_pack & p_pack1,
+                                           const t_pack & p_pack2)
+  {
+    return p_pack1 & p_pack2;
+  }
+
+  //----------------------------------------------------------------------------
+  scalar_pack::t_pack scalar_pack::bit_or(const t_pack & p_pack1,
+                                          const t_pack & p_pack2)
+  {
+    return p_pack1 | p_pack2;
+  }
+
+  //----------------------------------------------------------------------------
+  scalar_pack::t_pack scalar_pack::and_not(const t_pack & p_pack1,
+                                           const t_pack & p_pack2)
+  {
+    return p_pack1 & ~p_pack2;
+  }
+
+  //----------------------------------------------------------------------------
+  bool scalar_pack::is_zero(const t_pack & p_pack)
+  {
+    return !p_pack;
+  }
+
+#if defined(__AVX2__)
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::load(const uint64_t * p_words)
+  {
+    return _mm256_loadu_si256((const __m256i*)p_words);
+  }
+
+  //----------------------------------------------------------------------------
+  void simd_pack::store(uint64_t * p_words,
+                        const t_pack & p_pack)
+  {
+    _mm256_storeu_si256((__m256i*)p_words,p_pack);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::zero(void)
+  {
+    return _mm256_setzero_si256();
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::shift_left(const t_pack & p_pack,
+                                          const unsigned int & p_count)
+  {
+    return _mm256_slli_epi64(p_pack,p_count);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::shift_right(const t_pack & p_pack,
+                                           const unsigned int & p_count)
+  {
+    return _mm256_srli_epi64(p_pack,p_count);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::bit_and(const t_pack & p_pack1,
+                                       const t_pack & p_pack2)
+  {
+    return _mm256_and_si256(p_pack1,p_pack2);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::bit_or(const t_pack & p_pack1,
+                                      const t_pack & p_pack2)
+  {
+    return _mm256_or_si256(p_pack1,p_pack2);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::and_not(const t_pack & p_pack1,
+                                       const t_pack & p_pack2)
+  {
+    return _mm256_andnot_si256(p_pack2,p_pack1);
+  }
+
+  //----------------------------------------------------------------------------
+  bool simd_pack::is_zero(const t_pack & p_pack)
+  {
+    return _mm256_testz_si256(p_pack,p_pack);
+  }
+#elif defined(__SSE2__)
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::load(const uint64_t * p_words)
+  {
+    return _mm_loadu_si128((const __m128i*)p_words);
+  }
+
+  //----------------------------------------------------------------------------
+  void simd_pack::store(uint64_t * p_words,
+                        const t_pack & p_pack)
+  {
+    _mm_storeu_si128((__m128i*)p_words,p_pack);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::zero(void)
+  {
+    return _mm_setzero_si128();
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::shift_left(const t_pack & p_pack,
+                                          const unsigned int & p_count)
+  {
+    return _mm_slli_epi64(p_pack,p_count);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::shift_right(const t_pack & p_pack,
+                                           const unsigned int & p_count)
+  {
+    return _mm_srli_epi64(p_pack,p_count);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::bit_and(const t_pack & p_pack1,
+                                       const t_pack & p_pack2)
+  {
+    return _mm_and_si128(p_pack1,p_pack2);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::bit_or(const t_pack & p_pack1,
+                                      const t_pack & p_pack2)
+  {
+    return _mm_or_si128(p_pack1,p_pack2);
+  }
+
+  //----------------------------------------------------------------------------
+  simd_pack::t_pack simd_pack::and_not(const t_pack & p_pack1,
+                                       const t_pack & p_pack2)
+  {
+    return _mm_andnot_si128(p_pack2,p_pack1);
+  }
+
+  //----------------------------------------------------------------------------
+  bool simd_pack::is_zero(const t_pack & p_pack)
+  {
+    return 0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(p_pack,_mm_setzero_si128()));
+  }
+#endif // __AVX2__
+}
+#endif // WORD_PACK_H
+//EOF
@@ -0,0 +1,199 @@
+/*
+    This file is part of wireworld_systemc
+    Copyright (C) 2015  Julien Thevenon ( julien_thevenon at yahoo.fr )
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace wireworld_systemc
+{
+  // Thread pool executing rounds of independent tasks. Tasks of a round are
+  // dealt to per worker queues, a worker whose queue is empty steals tasks
+  // from the back of other queues. Calling thread works as worker 0 and run
+  // returns once every task of the round is done
+  class work_stealing_pool
+  {
+  public:
+    typedef std::function<void(const unsigned int & p_worker, const unsigned int & p_task)> t_job;
+
+    inline work_stealing_pool(const unsigned int & p_nb_workers);
+    inline ~work_stealing_pool(void);
+
+    inline void run(const t_job & p_job, const unsigned int & p_nb_tasks);
+    inline unsigned int get_nb_workers(void)const;
+  private:
+    class worker_queue
+    {
+    public:
+      std::mutex m_mutex;
+      std::deque<unsigned int> m_tasks;
+    };
+
+    inline void work(const unsigned int & p_worker);
+    inline void execute_tasks(const unsigned int & p_worker);
+    inline bool get_task(const unsigned int & p_worker, unsigned int & p_task);
+
+    std::vector<worker_queue> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start_condition;
+    std::condition_variable m_done_condition;
+    const t_job * m_job;
+    uint64_t m_round;
+    bool m_terminate;
+    std::atomic<unsigned int> m_remaining_tasks;
+  };
+
+  //----------------------------------------------------------------------------
+  work_stealing_pool::work_stealing_pool(const unsigned int & p_nb_workers):
+    m_queues(p_nb_workers ? p_nb_workers : 1),
+    m_job(nullptr),
+    m_round(0),
+    m_terminate(false),
+    m_remaining_tasks(0)
+    {
+      for(unsigned int l_worker = 1 ; l_worker < m_queues.size() ; ++l_worker)
+        {
+          m_threads.push_back(std::thread(&work_stealing_pool::work,this,l_worker));
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  work_stealing_pool::~work_stealing_pool(void)
+    {
+      {
+        std::lock_guard<std::mutex> l_lock(m_mutex);
+        m_terminate = true;
+      }
+      m_start_condition.notify_all();
+      for(auto & l_thread: m_threads)
+        {
+          l_thread.join();
+        }
+    }
+
+  //----------------------------------------------------------------------------
+  unsigned int work_stealing_pool::get_nb_workers(void)const
+  {
+    return m_queues.size();
+  }
+
+  //----------------------------------------------------------------------------
+  void work_stealing_pool::run(const t_job & p_job, const unsigned int & p_nb_tasks)
+  {
+    if(!p_nb_tasks)
+      {
+        return;
+      }
+    // Job and task count are published before tasks as a worker late on
+    // previous round may take a task as soon as it is queued
+    {
+      std::lock_guard<std::mutex> l_lock(m_mutex);
+      m_job = &p_job;
+      m_remaining_tasks = p_nb_tasks;
+      ++m_round;
+    }
+    for(unsigned int l_task = 0 ; l_task < p_nb_tasks ; ++l_task)
+      {
+        worker_queue & l_queue = m_queues[l_task % m_queues.size()];
+        std::lock_guard<std::mutex> l_lock(l_queue.m_mutex);
+        l_queue.m_tasks.push_back(l_task);
+      }
+    m_start_condition.notify_all();
+
+    execute_tasks(0);
+
+    // Generation barrier
+    std::unique_lock<std::mutex> l_lock(m_mutex);
+    m_done_condition.wait(l_lock,[this]{return !m_remaining_tasks;});
+  }
+
+  //----------------------------------------------------------------------------
+  void work_stealing_pool::work(const unsigned int & p_worker)
+  {
+    uint64_t l_round = 0;
+    while(true)
+      {
+        {
+          std::unique_lock<std::mutex> l_lock(m_mutex);
+          m_start_condition.wait(l_lock,[this,l_round]{return m_terminate || m_round != l_round;});
+          if(m_terminate)
+            {
+              return;
+            }
+          l_round = m_round;
+        }
+        execute_tasks(p_worker);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void work_stealing_pool::execute_tasks(const unsigned int & p_worker)
+  {
+    unsigned int l_task;
+    while(get_task(p_worker,l_task))
+      {
+        (*m_job)(p_worker,l_task);
+        if(1 == m_remaining_tasks.fetch_sub(1))
+          {
+            std::lock_guard<std::mutex> l_lock(m_mutex);
+            m_done_condition.notify_all();
+          }
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  bool work_stealing_pool::get_task(const unsigned int & p_worker, unsigned int & p_task)
+  {
+    // Own queue first
+    {
+      worker_queue & l_queue = m_queues[p_worker];
+      std::lock_guard<std::mutex> l_lock(l_queue.m_mutex);
+      if(!l_queue.m_tasks.empty())
+        {
+          p_task = l_queue.m_tasks.front();
+          l_queue.m_tasks.pop_front();
+          return true;
+        }
+    }
+    // Then steal from other workers
+    for(unsigned int l_offset = 1 ; l_offset < m_queues.size() ; ++l_offset)
+      {
+        worker_queue & l_queue = m_queues[(p_worker + l_offset) % m_queues.size()];
+        std::lock_guard<std::mutex> l_lock(l_queue.m_mutex);
+        if(!l_queue.m_tasks.empty())
+          {
+            p_task = l_queue.m_tasks.back();
+            l_queue.m_tasks.pop_back();
+            return true;
+          }
+      }
+    return false;
+  }
+}
+#endif // WORK_STEALING_POOL_H
+//EOF
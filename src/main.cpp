@@ -19,34 +19,99 @@
 #include "wireworld_parameters.h"
 #include "wireworld_types.h"
 #include "wireworld_configuration.h"
+#include "simulation_options.h"
+#include "cell_index.h"
+#include "checkpoint.h"
+#include "partition.h"
+#include "batch_runner.h"
+#include "engine_factory.h"
+#include "band_engine.h"
+#include "engine_runner.h"
 #include "top.h"
+#include <memory>
 
 int sc_main(int argc,char ** argv)
 {
   try
     {
+      wireworld_systemc::simulation_options l_options;
+      l_options.extract(argc,argv);
+
       wireworld_common::wireworld_configuration l_config;
-      wireworld_common::wireworld_types::t_cell_list l_copper_cells;
-      wireworld_common::wireworld_types::t_cell_list l_tail_cells;
-      wireworld_common::wireworld_types::t_cell_list l_electron_cells;
       wireworld_common::wireworld_types::t_cell_list l_inactive_cells;
-      wireworld_common::wireworld_types::t_neighbours l_neighbours;
       uint32_t l_x_max = 0;
       uint32_t l_y_max = 0;
+      uint64_t l_generation = 0;
+      std::vector<wireworld_common::wireworld_types::t_cell_state> l_states;
+      std::unique_ptr<wireworld_systemc::cell_index> l_index;
+      // Band engine reads states in place from restored netlist so that no
+      // per cell array is built
+      const uint8_t * l_mapped_states = nullptr;
+      bool l_band = !l_options.is_compile() && !l_options.is_batch() && !l_options.is_systemc_engine() && wireworld_systemc::simulation_options::t_engine::BAND == l_options.get_engine();
+
+      if(l_options.is_restore())
+        {
+          l_index.reset(wireworld_systemc::checkpoint::load(l_options.get_restore_file(),l_generation,l_states,l_config,l_x_max,l_y_max,l_inactive_cells,l_band ? &l_mapped_states : nullptr));
+        }
+      else
+        {
+          wireworld_common::wireworld_types::t_cell_list l_copper_cells;
+          wireworld_common::wireworld_types::t_cell_list l_tail_cells;
+          wireworld_common::wireworld_types::t_cell_list l_electron_cells;
+          wireworld_common::wireworld_types::t_neighbours l_neighbours;
+
+          wireworld_common::wireworld_prepare::prepare(argc,argv,
+                                                       l_config,
+                                                       l_copper_cells,
+                                                       l_tail_cells,
+                                                       l_electron_cells,
+                                                       l_inactive_cells,
+                                                       l_neighbours,
+                                                       l_x_max,
+                                                       l_y_max);
 
-      wireworld_common::wireworld_prepare::prepare(argc,argv,
-						   l_config,
-						   l_copper_cells,
-						   l_tail_cells,
-						   l_electron_cells,
-						   l_inactive_cells,
-						   l_neighbours,
-						   l_x_max,
-						   l_y_max);
+          // Dense cell index replaces coordinate keyed containers from here
+          l_index.reset(new wireworld_systemc::cell_index(l_copper_cells,l_neighbours,l_options.get_nb_threads(),l_options.get_cell_order()));
+          l_index->get_states(l_tail_cells,l_electron_cells,l_states);
+        }
 
-      wireworld_systemc::top l_top("top",l_copper_cells,l_tail_cells,l_electron_cells,l_config,l_x_max,l_y_max,l_inactive_cells,l_neighbours);
-      sc_start();
+      if(l_options.is_compile())
+        {
+          // Netlist is a snapshot carrying partitions of partition engine
+          wireworld_systemc::partition::t_partitionned_cells l_partitions;
+          wireworld_systemc::partition::assign(*l_index,l_options.get_partition_size(),l_partitions);
+          l_index->set_partitions(l_options.get_partition_size(),std::vector<uint32_t>(l_partitions.begin(),l_partitions.end()));
+          wireworld_systemc::checkpoint l_netlist(l_options.get_compile_file(),0,l_generation,*l_index,l_config,l_x_max,l_y_max,l_inactive_cells);
+          l_netlist.save(l_generation,l_states);
+          return 0;
+        }
 
+      if(l_options.is_batch())
+        {
+          wireworld_systemc::batch_runner l_runner(*l_index,l_states,l_generation,l_config.get_nb_max_cycle(),l_options.get_batch_lanes());
+          l_runner.run(l_options.get_batch_file(),std::cout);
+        }
+      else if(l_options.is_systemc_engine())
+        {
+          wireworld_systemc::top l_top("top",*l_index,l_states,l_generation,l_config,l_x_max,l_y_max,l_inactive_cells,l_options);
+          sc_start();
+        }
+      else
+        {
+          std::unique_ptr<wireworld_systemc::engine_if> l_engine;
+          if(l_mapped_states)
+            {
+              l_engine.reset(new wireworld_systemc::band_engine(*l_index,l_mapped_states,l_options.get_band_height(),l_options.get_band_directory()));
+            }
+          else
+            {
+              l_engine.reset(wireworld_systemc::engine_factory::create(l_options.get_engine(),*l_index,l_states,l_options));
+            }
+          // Engines keep their own copy of states
+          std::vector<wireworld_common::wireworld_types::t_cell_state>().swap(l_states);
+          wireworld_systemc::engine_runner l_runner(*l_engine,*l_index,l_generation,l_config,l_x_max,l_y_max,l_inactive_cells,l_options);
+          l_runner.run();
+        }
     }
   catch(quicky_exception::quicky_logic_exception & e)
     {